@@ -7,6 +7,7 @@
 #include <limits.h>
 
 #include "genericfp.hpp"
+#include "simd.hpp"
 
 template <unsigned size, typename fptype>
 fptype kahanSum(const fptype(&summands)[size]) {
@@ -34,9 +35,189 @@ fptype kahanSum(const fptype *summands, unsigned size) {
   return ret;
 }
 
+/* Neumaier's improvement to Kahan summation,
+ * also called Kahan-Babuska summation.
+ * The compensation is taken from whichever of the sum and
+ * the summand is smaller, so unlike kahanSum it remains
+ * correct when a summand is larger than the running sum.
+ * The compensation is only applied at the end.
+ */
+template <typename fptype>
+void neumaierAdd(fptype &sum, fptype &c, fptype val) {
+  fptype tmp = sum + val;
+  if(std::fabs(sum) >= std::fabs(val))
+    c += (sum - tmp) + val;
+  else
+    c += (val - tmp) + sum;
+  sum = tmp;
+}
+
+/* The same update as neumaierAdd, with the comparison
+ * replaced by Knuth's TwoSum.
+ * This costs three more flops, but has no branches or
+ * comparisons, so it can be applied to GCC vector types
+ */
+template <typename fptype>
+void neumaierAddBranchFree(fptype &sum, fptype &c,
+                           fptype val) {
+  fptype tmp = sum + val;
+  fptype valVirtual = tmp - sum;
+  fptype sumVirtual = tmp - valVirtual;
+  c += (sum - sumVirtual) + (val - valVirtual);
+  sum = tmp;
+}
+
+/* Klein's second order iterative Kahan-Babuska summation.
+ * The error of each Neumaier update is itself accumulated
+ * with a Neumaier update into cs,
+ * and the error of that goes into ccs
+ */
+template <typename fptype>
+void kleinAdd(fptype &sum, fptype &cs, fptype &ccs,
+              fptype val) {
+  fptype c = 0.0;
+  neumaierAdd(sum, c, val);
+  fptype cc = 0.0;
+  neumaierAdd(cs, cc, c);
+  ccs += cc;
+}
+
+template <typename fptype>
+void kleinAddBranchFree(fptype &sum, fptype &cs,
+                        fptype &ccs, fptype val) {
+  fptype c = {};
+  neumaierAddBranchFree(sum, c, val);
+  fptype cc = {};
+  neumaierAddBranchFree(cs, cc, c);
+  ccs += cc;
+}
+
+template <typename fptype>
+fptype neumaierSum(const fptype *summands, unsigned size) {
+  fptype ret = 0.0;
+  fptype c = 0.0;
+  for(unsigned i = 0; i < size; i++)
+    neumaierAdd(ret, c, summands[i]);
+  return ret + c;
+}
+
+template <typename fptype>
+fptype kleinSum(const fptype *summands, unsigned size) {
+  fptype ret = 0.0;
+  fptype cs = 0.0;
+  fptype ccs = 0.0;
+  for(unsigned i = 0; i < size; i++)
+    kleinAdd(ret, cs, ccs, summands[i]);
+  return ret + (cs + ccs);
+}
+
+/* The SIMD variants keep an independent sum and
+ * compensation per lane, so the summands are added in a
+ * different order than the scalar versions.
+ * The lanes are combined with the scalar algorithm
+ */
+template <typename fptype>
+fptype neumaierSumSIMD(const fptype *summands,
+                       unsigned size) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  vec sum = {}, c = {};
+  unsigned i = 0;
+  for(; i + lanes <= size; i += lanes)
+    neumaierAddBranchFree(sum, c,
+                          SIMD::load(summands + i));
+  neumaierAddBranchFree(
+      sum, c, SIMD::loadPartial(summands + i, size - i));
+  fptype ret = 0.0;
+  fptype scalarC = 0.0;
+  for(unsigned j = 0; j < lanes; j++) {
+    neumaierAdd(ret, scalarC, sum[j]);
+    scalarC += c[j];
+  }
+  return ret + scalarC;
+}
+
+template <typename fptype>
+fptype kleinSumSIMD(const fptype *summands,
+                    unsigned size) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  vec sum = {}, cs = {}, ccs = {};
+  unsigned i = 0;
+  for(; i + lanes <= size; i += lanes)
+    kleinAddBranchFree(sum, cs, ccs,
+                       SIMD::load(summands + i));
+  kleinAddBranchFree(
+      sum, cs, ccs,
+      SIMD::loadPartial(summands + i, size - i));
+  fptype ret = 0.0;
+  fptype scalarCS = 0.0;
+  fptype scalarCCS = 0.0;
+  for(unsigned j = 0; j < lanes; j++) {
+    kleinAdd(ret, scalarCS, scalarCCS, sum[j]);
+    kleinAdd(ret, scalarCS, scalarCCS, cs[j]);
+    kleinAdd(ret, scalarCS, scalarCCS, ccs[j]);
+  }
+  return ret + (scalarCS + scalarCCS);
+}
+
+template <typename fptype>
+fptype neumaierDotProdSIMD(const fptype *vec1,
+                           const fptype *vec2,
+                           unsigned dim) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  vec sum = {}, c = {};
+  unsigned i = 0;
+  for(; i + lanes <= dim; i += lanes)
+    neumaierAddBranchFree(sum, c,
+                          SIMD::load(vec1 + i) *
+                              SIMD::load(vec2 + i));
+  neumaierAddBranchFree(
+      sum, c, SIMD::loadPartial(vec1 + i, dim - i) *
+                  SIMD::loadPartial(vec2 + i, dim - i));
+  fptype ret = 0.0;
+  fptype scalarC = 0.0;
+  for(unsigned j = 0; j < lanes; j++) {
+    neumaierAdd(ret, scalarC, sum[j]);
+    scalarC += c[j];
+  }
+  return ret + scalarC;
+}
+
+template <typename fptype>
+fptype kleinDotProdSIMD(const fptype *vec1,
+                        const fptype *vec2, unsigned dim) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  vec sum = {}, cs = {}, ccs = {};
+  unsigned i = 0;
+  for(; i + lanes <= dim; i += lanes)
+    kleinAddBranchFree(
+        sum, cs, ccs,
+        SIMD::load(vec1 + i) * SIMD::load(vec2 + i));
+  kleinAddBranchFree(
+      sum, cs, ccs,
+      SIMD::loadPartial(vec1 + i, dim - i) *
+          SIMD::loadPartial(vec2 + i, dim - i));
+  fptype ret = 0.0;
+  fptype scalarCS = 0.0;
+  fptype scalarCCS = 0.0;
+  for(unsigned j = 0; j < lanes; j++) {
+    kleinAdd(ret, scalarCS, scalarCCS, sum[j]);
+    kleinAdd(ret, scalarCS, scalarCCS, cs[j]);
+    kleinAdd(ret, scalarCS, scalarCCS, ccs[j]);
+  }
+  return ret + (scalarCS + scalarCCS);
+}
+
 template <typename fptype>
 std::array<fptype, 2> twoSum(fptype a, fptype b) {
-  if(a < b) {
+  if(std::fabs(a) < std::fabs(b)) {
     fptype tmp = b;
     b = a;
     a = tmp;
@@ -56,6 +237,45 @@ std::array<fptype, 2> twoProd(fptype lhs, fptype rhs) {
   return products;
 }
 
+/* Knuth's TwoSum, which has no branches,
+ * so it can be applied to GCC vector types
+ */
+template <typename T>
+std::array<T, 2> twoSumBranchFree(T a, T b) {
+  T x = a + b;
+  T bVirtual = x - a;
+  T aVirtual = x - bVirtual;
+  T err = (a - aVirtual) + (b - bVirtual);
+  std::array<T, 2> sum = {{x, err}};
+  return sum;
+}
+
+/* Dekker's TwoProd with Veltkamp's splitting.
+ * This needs no FMA, so it can be applied to GCC vector
+ * types, where std::fma isn't available.
+ * fptype is the element type; the products are only exact
+ * when the scaled factors don't overflow
+ */
+template <typename fptype, typename T>
+std::array<T, 2> twoProdDekker(T lhs, T rhs) {
+  constexpr const int precision =
+      GenericFP::fpconvert<fptype>::precision;
+  const fptype factor =
+      std::ldexp(fptype(1.0), (precision + 1) / 2) + 1;
+  T lhsScaled = factor * lhs;
+  T lhsHigh = lhsScaled - (lhsScaled - lhs);
+  T lhsLow = lhs - lhsHigh;
+  T rhsScaled = factor * rhs;
+  T rhsHigh = rhsScaled - (rhsScaled - rhs);
+  T rhsLow = rhs - rhsHigh;
+  T prod = lhs * rhs;
+  T err = ((lhsHigh * rhsHigh - prod) + lhsHigh * rhsLow +
+           lhsLow * rhsHigh) +
+          lhsLow * rhsLow;
+  std::array<T, 2> products = {{prod, err}};
+  return products;
+}
+
 template <typename fptype>
 std::array<fptype, 3> threeFMA(fptype a, fptype b,
                                fptype c) {
@@ -65,10 +285,24 @@ std::array<fptype, 3> threeFMA(fptype a, fptype b,
   std::array<fptype, 2> sum2 = twoSum(mult[0], sum1[0]);
   fptype gamma = (sum2[0] - r1) + sum2[1];
   std::array<fptype, 2> sum3 = twoSum(gamma, sum1[1]);
-  std::array<fptype, 3> ret = {{r1, sum3[1], sum3[2]}};
+  std::array<fptype, 3> ret = {{r1, sum3[0], sum3[1]}};
   return ret;
 }
 
+/* Writes the exact products of the vectors as 2 * dim
+ * unevaluated terms, so any summation algorithm can be
+ * used to compute the dot product
+ */
+template <typename fptype>
+void twoProdSplit(const fptype *vec1, const fptype *vec2,
+                  unsigned dim, fptype *terms) {
+  for(unsigned i = 0; i < dim; i++) {
+    std::array<fptype, 2> prod = twoProd(vec1[i], vec2[i]);
+    terms[2 * i] = prod[0];
+    terms[2 * i + 1] = prod[1];
+  }
+}
+
 template <typename fptype>
 fptype compensatedDotProd(const fptype *vec1,
                           const fptype *vec2,
@@ -0,0 +1,206 @@
+
+#ifndef _BINNED_SUM_HPP_
+#define _BINNED_SUM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <assert.h>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "genericfp.hpp"
+#include "worker_pool.hpp"
+
+/* A reproducible accumulator in the style of ReproBLAS's
+ * binned numbers.
+ * The exponent range is cut into bins of binWidth bits at
+ * fixed positions, so the bins do not depend on the data.
+ * Each summand is pre-rounded into pieces which are
+ * multiples of a bin's unit, and each bin sums its pieces
+ * exactly.
+ * Unlike ReproBLAS, which keeps only a few bins below the
+ * largest summand, every bin is kept, so the accumulated
+ * value is exact.
+ * The result is its correctly rounded value, which depends
+ * only on the multiset of summands, not on their order or
+ * on how they were split between accumulators.
+ * Summands must be below 2^(minExp + numBins * binWidth),
+ * about 2^(precision + binWidth) below the overflow
+ * threshold, so that the extraction constants are finite.
+ */
+template <typename fptype>
+class BinnedSum {
+ public:
+  BinnedSum() : bins(numBins, 0.0), load(0), scratch() {}
+
+  void reset() {
+    bins.assign(numBins, 0.0);
+    load = 0;
+  }
+
+  void deposit(fptype val) {
+    if(load >= capacity / 2) renormalize();
+    /* Subnormals share the smallest normal exponent */
+    const int biasedExp = std::max(
+        int(GenericFP::gfFPStruct(val).exponent), 1);
+    /* |val| < 2^topExp */
+    const int topExp =
+        biasedExp -
+        int(GenericFP::fpconvert<fptype>::centralExp) + 1;
+    int bin = (topExp - minExp - 1) / binWidth;
+    assert(bin < (int)numBins);
+    while(val != 0.0) {
+      const fptype sigma = sigmas()[bin];
+      fptype piece = (sigma + val) - sigma;
+      bins[bin] += piece;
+      val -= piece;
+      bin--;
+    }
+    load++;
+  }
+
+  /* Adds the value of other to this accumulator exactly */
+  void merge(const BinnedSum &other) {
+    renormalize();
+    assert(load + other.load <= capacity);
+    for(unsigned i = 0; i < numBins; i++)
+      bins[i] += other.bins[i];
+    load += other.load;
+  }
+
+  fptype result() {
+    scratch.clear();
+    for(unsigned i = 0; i < numBins; i++) {
+      if(bins[i] != 0.0) scratch.push_back(bins[i]);
+    }
+    return iFastSum(scratch.data(), scratch.size());
+  }
+
+ private:
+  static constexpr const int precision =
+      GenericFP::fpconvert<fptype>::precision;
+  static constexpr const int binWidth = precision / 2;
+  /* The exponent of the smallest subnormal value,
+   * which is the unit of the lowest bin
+   */
+  static constexpr const int minExp =
+      std::numeric_limits<fptype>::min_exponent - precision;
+  /* The bins whose extraction constants are finite */
+  static constexpr const unsigned numBins =
+      (std::numeric_limits<fptype>::max_exponent - minExp -
+       precision) /
+          binWidth +
+      1;
+  /* A bin holds multiples of its unit of magnitude less
+   * than 2^binWidth units after each deposit,
+   * so it stays exact for this many deposits
+   */
+  static constexpr const unsigned capacity =
+      1u << (precision - binWidth - 1);
+
+  /* Adding and then subtracting sigmas()[i] rounds a value
+   * to a multiple of bin i's unit,
+   * 2^(minExp + i * binWidth)
+   */
+  static const std::vector<fptype> &sigmas() {
+    static const std::vector<fptype> table = [] {
+      std::vector<fptype> sigma(numBins);
+      for(unsigned i = 0; i < numBins; i++)
+        sigma[i] = fptype(1.5) *
+                   std::ldexp(fptype(1.0),
+                              minExp + int(i) * binWidth +
+                                  precision - 1);
+      return sigma;
+    }();
+    return table;
+  }
+
+  /* Carries the part of each bin which is a multiple of
+   * the next bin's unit into the next bin
+   */
+  void renormalize() {
+    for(unsigned i = 0; i + 1 < numBins; i++) {
+      const fptype sigma = sigmas()[i + 1];
+      fptype carry = (sigma + bins[i]) - sigma;
+      bins[i] -= carry;
+      bins[i + 1] += carry;
+    }
+    load = 1;
+  }
+
+  std::vector<fptype> bins;
+  unsigned load;
+  std::vector<fptype> scratch;
+};
+
+/* Deposits both terms of each exact product, so the
+ * result is the correctly rounded dot product
+ */
+template <typename fptype>
+void binnedDeposit(BinnedSum<fptype> &accumulator,
+                   const fptype *vec1, const fptype *vec2,
+                   unsigned dim) {
+  for(unsigned i = 0; i < dim; i++) {
+    std::array<fptype, 2> prod = twoProd(vec1[i], vec2[i]);
+    accumulator.deposit(prod[0]);
+    accumulator.deposit(prod[1]);
+  }
+}
+
+template <typename fptype>
+fptype binnedDotProd(const fptype *vec1, const fptype *vec2,
+                     unsigned dim) {
+  BinnedSum<fptype> accumulator;
+  binnedDeposit(accumulator, vec1, vec2, dim);
+  return accumulator.result();
+}
+
+/* Deposits the t-th of numThreads contiguous chunks of
+ * the products
+ */
+template <typename fptype>
+void binnedDepositChunk(BinnedSum<fptype> &accumulator,
+                        const fptype *vec1,
+                        const fptype *vec2, unsigned dim,
+                        unsigned t, unsigned numThreads) {
+  const unsigned begin = dim * t / numThreads;
+  const unsigned end = dim * (t + 1) / numThreads;
+  binnedDeposit(accumulator, vec1 + begin, vec2 + begin,
+                end - begin);
+}
+
+/* Splits the vectors into a contiguous chunk per thread of
+ * the pool, each accumulated by its own thread.
+ * The result is bitwise identical for any thread count
+ */
+template <typename fptype>
+fptype binnedDotProdParallel(const fptype *vec1,
+                             const fptype *vec2,
+                             unsigned dim,
+                             WorkerPool &pool) {
+  const unsigned numThreads = pool.size();
+  std::vector<BinnedSum<fptype>> partials(numThreads);
+  pool.run([&](unsigned t) {
+    binnedDepositChunk(partials[t], vec1, vec2, dim, t,
+                       numThreads);
+  });
+  for(unsigned t = 1; t < numThreads; t++)
+    partials[0].merge(partials[t]);
+  return partials[0].result();
+}
+
+/* Starts numThreads threads for just this product */
+template <typename fptype>
+fptype binnedDotProdParallel(const fptype *vec1,
+                             const fptype *vec2,
+                             unsigned dim,
+                             unsigned numThreads) {
+  WorkerPool pool(numThreads);
+  return binnedDotProdParallel(vec1, vec2, dim, pool);
+}
+
+#endif
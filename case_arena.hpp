@@ -0,0 +1,154 @@
+
+#ifndef _CASE_ARENA_HPP_
+#define _CASE_ARENA_HPP_
+
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <sys/mman.h>
+
+/* A bump allocator for the data of test cases.
+ * Memory is mapped in chunks which are kept until the arena
+ * is destroyed; reset makes all of it available again, so
+ * once the chunks cover the largest set of cases generated
+ * between resets, allocating maps nothing.
+ * Allocations are aligned to cache lines.
+ * Chunks are prefaulted when mapped, so the page faults
+ * aren't taken while the tests are timed.
+ * With hugePages, chunks are first mapped from the huge
+ * page pool, and if that fails, transparent huge pages are
+ * requested for them instead
+ */
+class CaseArena {
+ public:
+  static constexpr const size_t alignment = 64;
+  static constexpr const size_t chunkSize = 2 << 20;
+  static constexpr const size_t pageSize = 4096;
+
+  struct Statistics {
+    unsigned long allocations;
+    unsigned long bytesAllocated;
+    unsigned long resets;
+    unsigned long mappings;
+    unsigned long hugePageMappings;
+    unsigned long bytesMapped;
+    unsigned long peakBytesInUse;
+  };
+
+  CaseArena(bool hugePages = true)
+      : hugePages(hugePages),
+        chunks(),
+        current(0),
+        offset(0),
+        bytesInUse(0),
+        stats() {}
+
+  ~CaseArena() {
+    for(auto &chunk : chunks)
+      munmap(chunk.base, chunk.size);
+  }
+
+  CaseArena(const CaseArena &) = delete;
+  CaseArena &operator=(const CaseArena &) = delete;
+
+  void *allocate(size_t bytes) {
+    bytes = roundUp(bytes, alignment);
+    while(current < chunks.size() &&
+          offset + bytes > chunks[current].size) {
+      bytesInUse += chunks[current].size - offset;
+      current++;
+      offset = 0;
+    }
+    if(current == chunks.size()) mapChunk(bytes);
+    char *ptr =
+        static_cast<char *>(chunks[current].base) + offset;
+    offset += bytes;
+    bytesInUse += bytes;
+    if(bytesInUse > stats.peakBytesInUse)
+      stats.peakBytesInUse = bytesInUse;
+    stats.allocations++;
+    stats.bytesAllocated += bytes;
+    return ptr;
+  }
+
+  template <typename T>
+  T *allocate(size_t count) {
+    return static_cast<T *>(allocate(count * sizeof(T)));
+  }
+
+  /* Frees every allocation, keeping the chunks */
+  void reset() {
+    current = 0;
+    offset = 0;
+    bytesInUse = 0;
+    stats.resets++;
+  }
+
+  const Statistics &statistics() const { return stats; }
+
+  void printStats(std::ostream &out = std::cout) const {
+    out << "Case Arena Allocations: " << stats.allocations
+        << "\n"
+        << "Case Arena Bytes Allocated: "
+        << stats.bytesAllocated << "\n"
+        << "Case Arena Resets: " << stats.resets << "\n"
+        << "Case Arena Mappings: " << stats.mappings << ", "
+        << stats.hugePageMappings << " from Huge Pages\n"
+        << "Case Arena Bytes Mapped: " << stats.bytesMapped
+        << "\n"
+        << "Case Arena Peak Bytes in Use: "
+        << stats.peakBytesInUse << "\n";
+  }
+
+ private:
+  struct Chunk {
+    void *base;
+    size_t size;
+  };
+
+  static size_t roundUp(size_t val, size_t multiple) {
+    return (val + multiple - 1) / multiple * multiple;
+  }
+
+  void mapChunk(size_t minBytes) {
+    const size_t size = roundUp(minBytes, chunkSize);
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void *base = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if(hugePages) {
+      base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                  flags | MAP_HUGETLB | MAP_POPULATE, -1,
+                  0);
+      if(base != MAP_FAILED) stats.hugePageMappings++;
+    }
+#endif
+    if(base == MAP_FAILED) {
+      base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                  flags, -1, 0);
+      if(base == MAP_FAILED) throw std::bad_alloc();
+      /* Prefaulting after the advice lets the kernel back
+       * the chunk with transparent huge pages
+       */
+#if defined(MADV_HUGEPAGE)
+      if(hugePages) madvise(base, size, MADV_HUGEPAGE);
+#endif
+      volatile char *page = static_cast<char *>(base);
+      for(size_t i = 0; i < size; i += pageSize)
+        page[i] = 0;
+    }
+    chunks.push_back({base, size});
+    stats.mappings++;
+    stats.bytesMapped += size;
+  }
+
+  const bool hugePages;
+  std::vector<Chunk> chunks;
+  size_t current;
+  size_t offset;
+  size_t bytesInUse;
+  Statistics stats;
+};
+
+#endif
@@ -4,40 +4,111 @@
 #include "kobbelt.hpp"
 #include "mpreal.h"
 #include "accurate_math.hpp"
+#include "doubledouble.hpp"
+#include "faithful_sum.hpp"
+#include "binned_sum.hpp"
+#include "sorted_sum.hpp"
+#include "ozaki.hpp"
+#include "interval.hpp"
+#include "simd.hpp"
+#include "fixed_dim.hpp"
+#include "case_arena.hpp"
+#include "reference_cache.hpp"
+#include "fixed_mp.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <random>
+#include <type_traits>
 #include <typeinfo>
 #include <cmath>
 #include <fstream>
+#include <limits>
+#include <vector>
 
 #include <assert.h>
 #include <time.h>
 
+/* The precision of the statistics; the references use
+ * DotProdCase::referencePrecision
+ */
+constexpr const unsigned statBits = 1024;
+
 template <typename fptype>
 class DotProdCase : public NumericTester::TestCase {
  public:
+  /* The vectors are allocated by the case unless storage
+   * for both is given, as by DotProdBlock.
+   * The reference is loaded from the cache if the case's
+   * index is in its file, and computed otherwise
+   */
   DotProdCase(std::mt19937_64 &rgen, auto &signDist,
-              auto &expDist, auto &manDist, unsigned dim)
+              auto &expDist, auto &manDist, unsigned dim,
+              fptype *storage1 = NULL,
+              fptype *storage2 = NULL,
+              const ReferenceCache *cache = NULL,
+              unsigned long index = 0)
       : NumericTester::TestCase(),
-        v1(new fptype[dim]),
-        v2(new fptype[dim]),
+        v1(storage1 != NULL ? storage1 : new fptype[dim]),
+        v2(storage2 != NULL ? storage2 : new fptype[dim]),
+        ownsVectors(storage1 == NULL),
         dim(dim) {
-    mpfr::mpreal val1, val2;
+    assert((storage1 == NULL) == (storage2 == NULL));
     for(unsigned i = 0; i < dim; i++) {
       v1[i] =
           generateFPVal(rgen, signDist, expDist, manDist);
-      val1 = v1[i];
       v2[i] =
           generateFPVal(rgen, signDist, expDist, manDist);
-      val2 = v2[i];
-      correct = correct + val1 * val2;
     }
+    if(cache != NULL && index < cache->mappedSize())
+      cache->load(index, correct);
+    else
+      computeReference(referencePrecision(expDist, dim));
     correctRounded = correct.toLDouble();
   }
 
+  /* The least precision which holds every dot product of
+   * dim elements with biased exponents from expDist exactly
+   */
+  template <typename expdist>
+  static mpfr_prec_t referencePrecision(
+      const expdist &expDist, unsigned dim) {
+    constexpr const long bias =
+        GenericFP::fpconvert<fptype>::centralExp;
+    const long minExp = expDist.min() - bias + 1;
+    const long maxExp = expDist.max() - bias + 1;
+    return NumericTester::exactPrecision(
+        NumericTester::ulpExponent<fptype>(minExp), maxExp,
+        2, dim);
+  }
+
   virtual ~DotProdCase() {
-    delete[] v1;
-    delete[] v2;
+    if(ownsVectors) {
+      delete[] v1;
+      delete[] v2;
+    }
+  }
+
+  /* The configuration of the generator in the key of the
+   * reference caches
+   */
+  template <typename signdist, typename expdist,
+            typename mandist>
+  static std::vector<uint64_t> cacheConfig(
+      const signdist &signDist, const expdist &expDist,
+      const mandist &manDist, unsigned dim) {
+    return {sizeof(fptype),
+            std::numeric_limits<fptype>::digits,
+            (uint64_t)signDist.min(),
+            (uint64_t)signDist.max(),
+            (uint64_t)expDist.min(),
+            (uint64_t)expDist.max(),
+            (uint64_t)manDist.min(),
+            (uint64_t)manDist.max(),
+            dim};
   }
 
   static fptype generateFPVal(std::mt19937_64 &rgen,
@@ -57,125 +128,300 @@ class DotProdCase : public NumericTester::TestCase {
     }
   }
 
-  template <typename>
+  template <typename, typename, typename>
   friend class DPNaiveTest;
-  template <typename>
+  template <typename, typename, typename>
   friend class DPFMATest;
-  template <typename>
+  template <typename, typename, typename>
   friend class DPKahanTest;
-  template <typename>
+  template <typename, typename, typename>
   friend class DPFMAKahanTest;
+  template <typename, typename, typename>
+  friend class DPNeumaierTest;
+  template <typename, typename, typename>
+  friend class DPKleinTest;
   template <typename>
-  friend class DPExactFMACompTest;
+  friend class DPNeumaierSIMDTest;
   template <typename>
+  friend class DPKleinSIMDTest;
+  template <typename, typename>
+  friend class DPSortedTest;
+  template <typename>
+  friend class DPOzakiTest;
+  template <typename>
+  friend class DPBinnedTest;
+  template <typename>
+  friend class DPReproducibilityTest;
+  template <typename, typename, typename>
+  friend class DPExactFMACompTest;
+  template <typename, typename, typename>
   friend class DPKobbeltTest;
+  template <typename, typename>
+  friend class DPSplitSumTest;
+  template <typename>
+  friend class DPIntervalTest;
+  template <typename, typename>
+  friend class DPFixedDimTest;
 
  private:
+  /* References of up to maxFixedBits bits are accumulated
+   * on the stack, in the least FixedMP of a multiple of
+   * fixedStep bits which keeps them exact; wider ones are
+   * accumulated in place.
+   * Either way, correct gets the least precision which
+   * keeps it exact
+   */
+  static constexpr const unsigned fixedStep = 256;
+  static constexpr const unsigned maxFixedBits = 4096;
+
+  template <unsigned bits>
+  using FixedBits = std::integral_constant<unsigned, bits>;
+
+  void computeReference(mpfr_prec_t prec) {
+    computeReference(prec, FixedBits<fixedStep>());
+  }
+
+  template <unsigned bits>
+  void computeReference(mpfr_prec_t prec, FixedBits<bits>) {
+    if(prec > bits) {
+      computeReference(prec,
+                       FixedBits<bits + fixedStep>());
+      return;
+    }
+    using factor =
+        FixedMP<std::numeric_limits<fptype>::digits>;
+    FixedMP<bits> sum;
+    beginExactReference();
+    for(unsigned i = 0; i < dim; i++)
+      sum.addProduct(factor(v1[i]), factor(v2[i]));
+    correct.set_prec(prec);
+    mpfr_set(correct.mpfr_ptr(), sum.mpfr_srcptr(),
+             MPFR_RNDN);
+    endExactReference();
+  }
+
+  void computeReference(
+      mpfr_prec_t prec,
+      FixedBits<maxFixedBits + fixedStep>) {
+    correct.set_prec(prec);
+    mpfr::mpreal val1, val2;
+    beginExactReference();
+    for(unsigned i = 0; i < dim; i++) {
+      val1 = v1[i];
+      val2 = v2[i];
+      mpfr_fma(correct.mpfr_ptr(), val1.mpfr_srcptr(),
+               val2.mpfr_srcptr(), correct.mpfr_srcptr(),
+               MPFR_RNDN);
+    }
+    endExactReference();
+  }
+
   fptype *v1;
   fptype *v2;
+  const bool ownsVectors;
   fptype correctRounded;
   const unsigned dim;
 };
 
+/* A block of cases whose vectors share one allocation from
+ * the arena, which must not be reset while the block is
+ * alive.
+ * Every vector starts on a cache line, and the vectors of
+ * consecutive cases are adjacent, so a test streams through
+ * the block in order
+ */
+template <typename fptype>
+class DotProdBlock final : public NumericTester::CaseBlock {
+ public:
+  /* With a cache, the cases are numbered from firstIndex,
+   * and the references it doesn't have are added to it
+   */
+  template <typename signdist, typename expdist,
+            typename mandist>
+  DotProdBlock(CaseArena &arena, std::mt19937_64 &rgen,
+               signdist &signDist, expdist &expDist,
+               mandist &manDist, unsigned dim,
+               unsigned numCases,
+               ReferenceCache *cache = NULL,
+               unsigned long firstIndex = 0)
+      : stride(paddedSize(dim)),
+        storage(arena.allocate<fptype>(2 * numCases *
+                                       stride)),
+        cases() {
+    cases.reserve(numCases);
+    for(unsigned c = 0; c < numCases; c++) {
+      const unsigned long index = firstIndex + c;
+      cases.emplace_back(rgen, signDist, expDist, manDist,
+                         dim, storage + 2 * c * stride,
+                         storage + (2 * c + 1) * stride,
+                         cache, index);
+      if(cache != NULL && index >= cache->size())
+        cache->store(index, cases[c].correctValue());
+    }
+  }
+
+  DotProdBlock(const DotProdBlock &) = delete;
+  DotProdBlock &operator=(const DotProdBlock &) = delete;
+
+  virtual unsigned size() const { return cases.size(); }
+
+  virtual const DotProdCase<fptype> &operator[](
+      unsigned i) const {
+    return cases[i];
+  }
+
+ private:
+  /* Rounds dim up to a whole number of cache lines */
+  static unsigned paddedSize(unsigned dim) {
+    constexpr const unsigned lineSize =
+        CaseArena::alignment / sizeof(fptype);
+    return (dim + lineSize - 1) / lineSize * lineSize;
+  }
+
+  const unsigned stride;
+  fptype *storage;
+  std::vector<DotProdCase<fptype>> cases;
+};
+
 /* Use the Curiously Recurring Template Pattern (CRTP)
- * to implement static polymorphism here
+ * to implement static polymorphism here.
+ * intype is the element type of the case vectors,
+ * prodtype is the type the elementwise products are
+ * formed in, and accumtype is the type they are summed in
  */
-template <typename fptype, typename derived>
+template <typename intype, typename prodtype,
+          typename accumtype, typename derived>
 class DPTestInterface : public NumericTester::NumericTest {
  public:
   virtual void updateStats(
       const NumericTester::TestCase &testCase) {
-    fptype result = 0.0;
-    if(typeid(testCase) ==
-       typeid(const DotProdCase<float>)) {
-      const DotProdCase<float> *dpCase =
-          static_cast<const DotProdCase<float> *>(
-              &testCase);
-      startTimer();
-      result =
-          static_cast<derived *>(this)->runTest(dpCase);
-      stopTimer();
-    } else if(typeid(testCase) ==
-              typeid(const DotProdCase<double>)) {
-      const DotProdCase<double> *dpCase =
-          static_cast<const DotProdCase<double> *>(
-              &testCase);
-      startTimer();
-      result =
-          static_cast<derived *>(this)->runTest(dpCase);
-      stopTimer();
-    } else if(typeid(testCase) ==
-              typeid(const DotProdCase<long double>)) {
-      const DotProdCase<long double> *dpCase =
-          static_cast<const DotProdCase<long double> *>(
-              &testCase);
-      startTimer();
-      result =
-          static_cast<derived *>(this)->runTest(dpCase);
-      stopTimer();
-    }
+    assert(typeid(testCase) ==
+           typeid(const DotProdCase<intype>));
+    const DotProdCase<intype> *dpCase =
+        static_cast<const DotProdCase<intype> *>(
+            &testCase);
+    startTimer();
+    accumtype result =
+        static_cast<derived *>(this)->runTest(dpCase);
+    stopTimer();
     mpfr::mpreal estimate(result);
     addStatistic(estimate, testCase.correctValue());
   }
+
+  /* Times the whole block at once, keeping the results
+   * until the timer is stopped
+   */
+  virtual void updateStatsBatch(
+      const NumericTester::CaseBlock &block) {
+    assert(typeid(block) ==
+           typeid(const DotProdBlock<intype>));
+    const DotProdBlock<intype> &dpBlock =
+        static_cast<const DotProdBlock<intype> &>(block);
+    const unsigned size = dpBlock.size();
+    results.resize(size);
+    derived *test = static_cast<derived *>(this);
+    startTimer();
+    for(unsigned i = 0; i < size; i++)
+      results[i] = test->runTest(&dpBlock[i]);
+    stopTimer();
+    for(unsigned i = 0; i < size; i++) {
+      mpfr::mpreal estimate(results[i]);
+      addStatistic(estimate, dpBlock[i].correctValue());
+    }
+  }
+
+ protected:
+  /* Names a single precision when all three types agree,
+   * otherwise names each of them
+   */
+  static std::string precisionName() {
+    const std::string inName =
+        GenericFP::fpconvert<intype>::fpname;
+    const std::string prodName =
+        GenericFP::fpconvert<prodtype>::fpname;
+    const std::string accumName =
+        GenericFP::fpconvert<accumtype>::fpname;
+    if(inName == prodName && prodName == accumName)
+      return inName;
+    return inName + " Inputs, " + prodName +
+           " Products, " + accumName + " Accumulator";
+  }
+
+ private:
+  std::vector<accumtype> results;
 };
 
-template <typename fptype>
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPNaiveTest
-    : public DPTestInterface<fptype, DPNaiveTest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPNaiveTest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string("Naive Dot Product with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    fptype accumulator = 0.0;
+    accumtype accumulator = 0.0;
     for(unsigned i = 0; i < dpCase->dim; i++)
-      accumulator += dpCase->v1[i] * dpCase->v2[i];
+      accumulator += accumtype(prodtype(dpCase->v1[i]) *
+                               prodtype(dpCase->v2[i]));
     return accumulator;
   }
 };
 
-template <typename fptype>
+/* The product is fused into the accumulation,
+ * so it is formed with the accumulator's precision
+ */
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPFMATest
-    : public DPTestInterface<fptype, DPFMATest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPFMATest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string("FMA Dot Product with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    intype accumulator = 0.0;
+    using std::fma;
+    accumtype accumulator = 0.0;
     for(unsigned i = 0; i < dpCase->dim; i++) {
-      accumulator = std::fma(dpCase->v1[i], dpCase->v2[i],
-                             accumulator);
+      accumulator = fma(accumtype(dpCase->v1[i]),
+                        accumtype(dpCase->v2[i]),
+                        accumulator);
     }
     return accumulator;
   }
 };
 
-template <typename fptype>
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPKahanTest
-    : public DPTestInterface<fptype, DPKahanTest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPKahanTest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string("Kahan Dot Product with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    fptype accumulator = 0.0;
-    fptype c = 0.0;
+    accumtype accumulator = 0.0;
+    accumtype c = 0.0;
     for(unsigned i = 0; i < dpCase->dim; i++) {
-      fptype mod = dpCase->v1[i] * dpCase->v2[i] - c;
-      fptype tmp = accumulator + mod;
+      accumtype mod = accumtype(prodtype(dpCase->v1[i]) *
+                                prodtype(dpCase->v2[i])) -
+                      c;
+      accumtype tmp = accumulator + mod;
       c = (tmp - accumulator) - mod;
       accumulator = tmp;
     }
@@ -183,25 +429,27 @@ class DPKahanTest
   }
 };
 
-template <typename fptype>
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPFMAKahanTest
-    : public DPTestInterface<fptype,
-                             DPFMAKahanTest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPFMAKahanTest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string("Kahan FMA Dot Product with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    fptype accumulator = 0.0;
-    fptype c = 0.0;
+    using std::fma;
+    accumtype accumulator = 0.0;
+    accumtype c = 0.0;
     for(unsigned i = 0; i < dpCase->dim; i++) {
-      fptype mod =
-          std::fma(dpCase->v1[i], dpCase->v2[i], -c);
-      fptype tmp = accumulator + mod;
+      accumtype mod = fma(accumtype(dpCase->v1[i]),
+                          accumtype(dpCase->v2[i]), -c);
+      accumtype tmp = accumulator + mod;
       c = (tmp - accumulator) - mod;
       accumulator = tmp;
     }
@@ -209,56 +457,643 @@ class DPFMAKahanTest
   }
 };
 
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
+class DPNeumaierTest
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPNeumaierTest<intype, prodtype, accumtype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Neumaier Dot Product with ") +
+           this->precisionName();
+  }
+
+  accumtype __attribute__((noinline))
+  runTest(const DotProdCase<intype> *dpCase) {
+    accumtype accumulator = 0.0;
+    accumtype c = 0.0;
+    for(unsigned i = 0; i < dpCase->dim; i++) {
+      neumaierAdd(accumulator, c,
+                  accumtype(prodtype(dpCase->v1[i]) *
+                            prodtype(dpCase->v2[i])));
+    }
+    return accumulator + c;
+  }
+};
+
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
+class DPKleinTest
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPKleinTest<intype, prodtype, accumtype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Klein Dot Product with ") +
+           this->precisionName();
+  }
+
+  accumtype __attribute__((noinline))
+  runTest(const DotProdCase<intype> *dpCase) {
+    accumtype accumulator = 0.0;
+    accumtype cs = 0.0;
+    accumtype ccs = 0.0;
+    for(unsigned i = 0; i < dpCase->dim; i++) {
+      kleinAdd(accumulator, cs, ccs,
+               accumtype(prodtype(dpCase->v1[i]) *
+                         prodtype(dpCase->v2[i])));
+    }
+    return accumulator + (cs + ccs);
+  }
+};
+
+/* The SIMD kernels work in a single precision,
+ * which must be float or double
+ */
+template <typename fptype>
+class DPNeumaierSIMDTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPNeumaierSIMDTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("SIMD Neumaier Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    return neumaierDotProdSIMD(dpCase->v1, dpCase->v2,
+                               dpCase->dim);
+  }
+};
+
 template <typename fptype>
+class DPKleinSIMDTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPKleinSIMDTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("SIMD Klein Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    return kleinDotProdSIMD(dpCase->v1, dpCase->v2,
+                            dpCase->dim);
+  }
+};
+
+/* Dispatches to a kernel specialized on the case's
+ * dimension, to compare with the runtime loops above
+ */
+template <typename fptype, typename kernel>
+class DPFixedDimTest
+    : public DPTestInterface<
+          fptype, fptype, fptype,
+          DPFixedDimTest<fptype, kernel>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Fixed Size ") + kernel::name +
+           " Dot Product with " + this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    return fixedDimDotProd<kernel>(dpCase->v1, dpCase->v2,
+                                   dpCase->dim);
+  }
+};
+
+/* The error free transformations are computed in prodtype,
+ * which must be a hardware floating point type
+ */
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPExactFMACompTest
-    : public DPTestInterface<fptype,
-                             DPExactFMACompTest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPExactFMACompTest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string(
                "Exact FMA Compensated Dot Product "
                "with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    std::array<intype, 2> terms(
-        twoProd(dpCase->v1[0], dpCase->v2[0]));
+    std::array<prodtype, 2> terms(
+        twoProd(prodtype(dpCase->v1[0]),
+                prodtype(dpCase->v2[0])));
     for(unsigned i = 1; i < dpCase->dim; i++) {
-      std::array<intype, 3> accumulated(
-          threeFMA(dpCase->v1[i], dpCase->v2[i], terms[0]));
+      std::array<prodtype, 3> accumulated(threeFMA(
+          prodtype(dpCase->v1[i]), prodtype(dpCase->v2[i]),
+          terms[0]));
       terms[0] = accumulated[0];
       terms[1] += (accumulated[1] + accumulated[2]);
     }
-    return fptype(terms[0] + terms[1]);
+    return accumtype(terms[0]) + accumtype(terms[1]);
   }
 };
 
-template <typename fptype>
+template <typename intype, typename prodtype = intype,
+          typename accumtype = prodtype>
 class DPKobbeltTest
-    : public DPTestInterface<fptype,
-                             DPKobbeltTest<fptype>> {
+    : public DPTestInterface<
+          intype, prodtype, accumtype,
+          DPKobbeltTest<intype, prodtype, accumtype>> {
  public:
   virtual std::string testName() {
     return std::string("Kobbelt Dot Product with ") +
-           GenericFP::fpconvert<fptype>::fpname;
+           this->precisionName();
   }
 
-  template <typename intype>
-  fptype __attribute__((noinline))
+  accumtype __attribute__((noinline))
   runTest(const DotProdCase<intype> *dpCase) {
-    return kobbeltDotProd<intype, fptype>(
+    return kobbeltDotProd<prodtype, accumtype>(
         dpCase->v1, dpCase->v2, dpCase->dim);
   }
 };
 
-void runTests(const int numTests, const int vecSize);
+template <typename fptype>
+class DPOzakiTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPOzakiTest<fptype>> {
+ public:
+  DPOzakiTest(unsigned numSlices) : ozaki(numSlices) {}
+
+  virtual std::string testName() {
+    return std::string("Ozaki ") +
+           std::to_string(ozaki.slices()) +
+           " Slice Dot Product with " +
+           this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    return ozaki.dotProd(dpCase->v1, dpCase->v2,
+                         dpCase->dim);
+  }
+
+ private:
+  OzakiScheme<fptype> ozaki;
+};
+
+/* Sums the 2 * dim terms of twoProdSplit with one of
+ * the faithful or correctly rounded summation algorithms.
+ * The terms buffer is kept between cases so that it is
+ * only allocated when the vector size grows
+ */
+template <typename fptype, typename derived>
+class DPSplitSumTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             derived> {
+ public:
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    terms.resize(2 * dpCase->dim);
+    twoProdSplit(dpCase->v1, dpCase->v2, dpCase->dim,
+                 terms.data());
+    return static_cast<derived *>(this)->sum(terms.data(),
+                                             terms.size());
+  }
+
+ protected:
+  std::vector<fptype> terms;
+};
+
+template <typename fptype>
+class DPAccSumTest
+    : public DPSplitSumTest<fptype, DPAccSumTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("AccSum Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype sum(fptype *summands, unsigned size) {
+    return accSum(summands, size);
+  }
+};
+
+template <typename fptype>
+class DPFastAccSumTest
+    : public DPSplitSumTest<fptype,
+                            DPFastAccSumTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("FastAccSum Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype sum(fptype *summands, unsigned size) {
+    return fastAccSum(summands, size);
+  }
+};
+
+template <typename fptype>
+class DPiFastSumTest
+    : public DPSplitSumTest<fptype,
+                            DPiFastSumTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("iFastSum Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype sum(fptype *summands, unsigned size) {
+    return iFastSum(summands, size);
+  }
+};
+
+template <typename fptype>
+class DPOnlineExactSumTest
+    : public DPSplitSumTest<fptype,
+                            DPOnlineExactSumTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("OnlineExactSum Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype sum(fptype *summands, unsigned size) {
+    accumulator.reset();
+    for(unsigned i = 0; i < size; i++)
+      accumulator.add(summands[i]);
+    return accumulator.result();
+  }
+
+ private:
+  OnlineExactSum<fptype> accumulator;
+};
+
+/* Binned summation of the exact products,
+ * which is reproducible and correctly rounded
+ */
+template <typename fptype>
+class DPBinnedTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPBinnedTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Binned Dot Product with ") +
+           this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    accumulator.reset();
+    binnedDeposit(accumulator, dpCase->v1, dpCase->v2,
+                  dpCase->dim);
+    return accumulator.result();
+  }
+
+ private:
+  BinnedSum<fptype> accumulator;
+};
+
+/* Times the binned dot product split over numThreads
+ * threads of a persistent pool, with the elapsed time.
+ * A block's cases are split with a single task, so the
+ * threads are woken once per block rather than per case.
+ * Then it checks untimed that the result is
+ * bitwise identical for every thread count up to
+ * numThreads and for random permutations of the terms.
+ * The naive dot product is checked against the same
+ * permutations for comparison
+ */
+template <typename fptype>
+class DPReproducibilityTest
+    : public DPTestInterface<
+          fptype, fptype, fptype,
+          DPReproducibilityTest<fptype>> {
+ public:
+  DPReproducibilityTest(unsigned numThreads,
+                        unsigned numPermutations = 4)
+      : numThreads(numThreads),
+        numPermutations(numPermutations),
+        threadMismatches(0),
+        binnedMismatches(0),
+        naiveMismatches(0),
+        engine(0),
+        v1(),
+        v2(),
+        pool(numThreads),
+        partials(),
+        results() {
+    this->useWallClock();
+  }
+
+  virtual std::string testName() {
+    return std::string("Reproducible Binned Dot Product "
+                       "with ") +
+           this->precisionName() + ", " +
+           std::to_string(numThreads) + " Threads";
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    DPTestInterface<fptype, fptype, fptype,
+                    DPReproducibilityTest<fptype>>::
+        updateStats(testCase);
+    checkCase(static_cast<const DotProdCase<fptype> *>(
+        &testCase));
+  }
+
+  /* Each thread deposits its chunk of every case of the
+   * block, and then every case is checked
+   */
+  virtual void updateStatsBatch(
+      const NumericTester::CaseBlock &block) {
+    assert(typeid(block) ==
+           typeid(const DotProdBlock<fptype>));
+    const DotProdBlock<fptype> &dpBlock =
+        static_cast<const DotProdBlock<fptype> &>(block);
+    const unsigned size = dpBlock.size();
+    if(partials.size() < size * numThreads)
+      partials.resize(size * numThreads);
+    results.resize(size);
+    this->startTimer();
+    pool.run([&](unsigned t) {
+      for(unsigned i = 0; i < size; i++) {
+        BinnedSum<fptype> &partial =
+            partials[i * numThreads + t];
+        partial.reset();
+        binnedDepositChunk(partial, dpBlock[i].v1,
+                           dpBlock[i].v2, dpBlock[i].dim, t,
+                           numThreads);
+      }
+    });
+    for(unsigned i = 0; i < size; i++) {
+      BinnedSum<fptype> *casePartials =
+          &partials[i * numThreads];
+      for(unsigned t = 1; t < numThreads; t++)
+        casePartials[0].merge(casePartials[t]);
+      results[i] = casePartials[0].result();
+    }
+    this->stopTimer();
+    for(unsigned i = 0; i < size; i++) {
+      mpfr::mpreal estimate(results[i]);
+      this->addStatistic(estimate,
+                         dpBlock[i].correctValue());
+      checkCase(&dpBlock[i]);
+    }
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    return binnedDotProdParallel(dpCase->v1, dpCase->v2,
+                                 dpCase->dim, pool);
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    out << "Thread Count Mismatches: " << threadMismatches
+        << "\n"
+        << "Permutation Mismatches: " << binnedMismatches
+        << "\n"
+        << "Naive Permutation Mismatches: "
+        << naiveMismatches << "\n";
+  }
+
+ private:
+  void checkCase(const DotProdCase<fptype> *dpCase) {
+    const unsigned dim = dpCase->dim;
+    const fptype binned =
+        binnedDotProd(dpCase->v1, dpCase->v2, dim);
+    for(unsigned t = 2; t <= numThreads; t++) {
+      if(!sameBits(binned,
+                   binnedDotProdParallel(
+                       dpCase->v1, dpCase->v2, dim, t)))
+        threadMismatches++;
+    }
+    const fptype naive =
+        naiveDotProd(dpCase->v1, dpCase->v2, dim);
+    v1.assign(dpCase->v1, dpCase->v1 + dim);
+    v2.assign(dpCase->v2, dpCase->v2 + dim);
+    for(unsigned p = 0; p < numPermutations; p++) {
+      /* Permute both vectors the same way */
+      for(unsigned i = dim - 1; i > 0; i--) {
+        std::uniform_int_distribution<unsigned> pick(0, i);
+        unsigned j = pick(engine);
+        std::swap(v1[i], v1[j]);
+        std::swap(v2[i], v2[j]);
+      }
+      if(!sameBits(binned, binnedDotProd(v1.data(),
+                                         v2.data(), dim)))
+        binnedMismatches++;
+      if(!sameBits(naive, naiveDotProd(v1.data(),
+                                       v2.data(), dim)))
+        naiveMismatches++;
+    }
+  }
+
+  static bool sameBits(fptype lhs, fptype rhs) {
+    return std::memcmp(&lhs, &rhs, sizeof(fptype)) == 0;
+  }
+
+  static fptype naiveDotProd(const fptype *vec1,
+                             const fptype *vec2,
+                             unsigned dim) {
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < dim; i++)
+      accumulator += vec1[i] * vec2[i];
+    return accumulator;
+  }
+
+  const unsigned numThreads;
+  const unsigned numPermutations;
+  unsigned long threadMismatches;
+  unsigned long binnedMismatches;
+  unsigned long naiveMismatches;
+  std::mt19937_64 engine;
+  std::vector<fptype> v1, v2;
+  WorkerPool pool;
+  std::vector<BinnedSum<fptype>> partials;
+  std::vector<fptype> results;
+};
+
+/* Sums the products in the order given by order::key,
+ * with the radix sort included in the timing.
+ * The buffers are kept between cases so that they are
+ * only allocated when the vector size grows
+ */
+template <typename fptype, typename order>
+class DPSortedTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPSortedTest<fptype, order>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Sorted by ") + order::name +
+           " Dot Product with " + this->precisionName();
+  }
+
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    products.resize(dpCase->dim);
+    scratch.resize(dpCase->dim);
+    for(unsigned i = 0; i < dpCase->dim; i++)
+      products[i] = dpCase->v1[i] * dpCase->v2[i];
+    radixSort<fptype, order>(products.data(),
+                             scratch.data(), dpCase->dim);
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < dpCase->dim; i++)
+      accumulator += products[i];
+    return accumulator;
+  }
+
+ private:
+  std::vector<fptype> products;
+  std::vector<fptype> scratch;
+};
+
+/* Encloses the dot product in an interval with upward
+ * rounding; the rounding mode is switched outside of the
+ * timed region, as a batch of dot products would only
+ * switch it once.
+ * The midpoint is added to the statistics, and the test
+ * reports the enclosure widths relative to the exact
+ * result, how often the sign is certified, and the cost
+ * relative to the FMA dot product on the same case.
+ * An enclosure which misses the exact result is a bug,
+ * and is counted separately
+ */
+template <typename fptype>
+class DPIntervalTest
+    : public DPTestInterface<fptype, fptype, fptype,
+                             DPIntervalTest<fptype>> {
+ public:
+  DPIntervalTest()
+      : certified(0),
+        enclosureFailures(0),
+        cases(0),
+        accumWidth(0.0),
+        fmaTime({0, 0}),
+        enclosure() {}
+
+  virtual std::string testName() {
+    return std::string("Interval Dot Product with ") +
+           this->precisionName();
+  }
+
+  /* Every case is compared with the FMA dot product,
+   * so blocks are processed a case at a time
+   */
+  virtual void updateStatsBatch(
+      const NumericTester::CaseBlock &block) {
+    NumericTester::NumericTest::updateStatsBatch(block);
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const DotProdCase<fptype>));
+    const DotProdCase<fptype> *dpCase =
+        static_cast<const DotProdCase<fptype> *>(
+            &testCase);
+    {
+      UpwardRounding rounding;
+      this->startTimer();
+      runTest(dpCase);
+      this->stopTimer();
+    }
+    timeFMA(dpCase);
+    const mpfr::mpreal &correct = testCase.correctValue();
+    mpfr::mpreal lower(enclosure.lower());
+    mpfr::mpreal upper(enclosure.upper());
+    if(lower > correct || upper < correct)
+      enclosureFailures++;
+    if(certifiedSign(enclosure) != 0) certified++;
+    cases++;
+    if(correct != 0)
+      accumWidth += (upper - lower) / abs(correct);
+    mpfr::mpreal midpoint = (lower + upper) / 2;
+    this->addStatistic(midpoint, correct);
+  }
+
+  /* Leaves the interval in enclosure, and returns its
+   * upper bound for DPTestInterface
+   */
+  fptype __attribute__((noinline))
+  runTest(const DotProdCase<fptype> *dpCase) {
+    enclosure = intervalDotProd(dpCase->v1, dpCase->v2,
+                                dpCase->dim);
+    return enclosure.upper();
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    const struct timespec time = this->totalRunTime();
+    out << "Average Relative Enclosure Width: "
+        << accumWidth / cases << "\n"
+        << "Certified Signs: " << certified << " of "
+        << cases << "\n"
+        << "Enclosure Failures: " << enclosureFailures
+        << "\n"
+        << "Cost Relative to FMA: "
+        << (time.tv_sec + time.tv_nsec * 1e-9) /
+               (fmaTime.tv_sec + fmaTime.tv_nsec * 1e-9)
+        << "x\n";
+  }
+
+ private:
+  void timeFMA(const DotProdCase<fptype> *dpCase) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    volatile fptype result = fmaDotProd(dpCase);
+    (void)result;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    fmaTime.tv_sec += end.tv_sec - start.tv_sec;
+    fmaTime.tv_nsec += end.tv_nsec - start.tv_nsec;
+  }
+
+  static fptype __attribute__((noinline))
+  fmaDotProd(const DotProdCase<fptype> *dpCase) {
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < dpCase->dim; i++)
+      accumulator = std::fma(dpCase->v1[i], dpCase->v2[i],
+                             accumulator);
+    return accumulator;
+  }
+
+  unsigned long certified;
+  unsigned long enclosureFailures;
+  unsigned long cases;
+  mpfr::mpreal accumWidth;
+  struct timespec fmaTime;
+  Interval<fptype> enclosure;
+};
+
+void runTests(const int numTests, const int vecSize,
+              const uint64_t *cacheSeed);
+void runReproTests(const int numTests, const int vecSize,
+                   const int numThreads,
+                   const uint64_t *cacheSeed);
 
 int main(int argc, char **argv) {
   int numTests = 1e5;
   int vecSize = 4;
+  int numThreads = 0;
+  /* dptest cached <seed> [numTests] [vecSize] [numThreads]
+   * generates the cases from the seed, and keeps their
+   * references in files in the working directory, so
+   * reruns with the same seed don't recompute them
+   */
+  uint64_t seed = 0;
+  const uint64_t *cacheSeed = NULL;
+  if(argc > 1 && std::strcmp(argv[1], "cached") == 0) {
+    if(argc < 3) {
+      printf("A cached run needs a seed\n");
+      return -1;
+    }
+    seed = std::strtoull(argv[2], NULL, 0);
+    cacheSeed = &seed;
+    argc -= 2;
+    argv += 2;
+  }
   if(argc > 1) {
     numTests = atoi(argv[1]);
     if(numTests < 1) {
@@ -271,53 +1106,245 @@ int main(int argc, char **argv) {
         printf("Vector size must be greater than 0\n");
         return -1;
       }
+      /* Giving a thread count runs the reproducibility
+       * checks instead of the full comparison
+       */
+      if(argc > 3) {
+        numThreads = atoi(argv[3]);
+        if(numThreads < 1) {
+          printf(
+              "Number of threads must be greater than "
+              "0\n");
+          return -1;
+        }
+      }
     }
   }
-  runTests(numTests, vecSize);
+  if(numThreads > 0)
+    runReproTests(numTests, vecSize, numThreads,
+                  cacheSeed);
+  else
+    runTests(numTests, vecSize, cacheSeed);
   return 0;
 }
 
-void runTests(const int numTests, const int vecSize) {
-  mpfr::mpreal::set_default_prec(1024);
-  std::random_device rd;
-  std::mt19937_64 engine(rd());
+/* With a cacheSeed, the engine is seeded with it, so the
+ * cases only depend on it and the generator's
+ * configuration, and their references are loaded from and
+ * added to the type's cache for it
+ */
+template <typename intype, unsigned numDPTests>
+void updateTests(
+    std::mt19937_64 &engine,
+    NumericTester::NumericTest *(&tests)[numDPTests],
+    const int numTests, const int vecSize,
+    const uint64_t *cacheSeed) {
   std::uniform_int_distribution<int> rgenExp(
-      0, GenericFP::fpconvert<float>::centralExp + 20);
-  std::uniform_int_distribution<int> rgenMan(
-      0, GenericFP::fpconvert<float>::maxMantissa);
+      0, GenericFP::fpconvert<intype>::centralExp + 20);
+  std::uniform_int_distribution<unsigned long> rgenMan(
+      0, GenericFP::fpconvert<intype>::maxMantissa);
   std::uniform_int_distribution<int> rgenSign(0, 1);
-  NumericTester::NumericTest *tests[] = {
+  const mpfr_prec_t refPrec =
+      DotProdCase<intype>::referencePrecision(rgenExp,
+                                              vecSize);
+  std::unique_ptr<ReferenceCache> cache;
+  if(cacheSeed != NULL) {
+    engine.seed(*cacheSeed);
+    cache.reset(new ReferenceCache(
+        std::string(GenericFP::fpconvert<intype>::fpname)
+            .append(" References ")
+            .append(std::to_string(*cacheSeed))
+            .append(".cache"),
+        *cacheSeed,
+        DotProdCase<intype>::cacheConfig(
+            rgenSign, rgenExp, rgenMan, vecSize),
+        refPrec));
+  }
+  /* Every block reuses the arena's memory */
+  constexpr const int blockSize = 256;
+  CaseArena arena;
+  for(int i = 0; i < numTests; i += blockSize) {
+    arena.reset();
+    DotProdBlock<intype> block(
+        arena, engine, rgenSign, rgenExp, rgenMan, vecSize,
+        std::min(blockSize, numTests - i), cache.get(), i);
+    for(auto t : tests) t->updateStatsBatch(block);
+  }
+  std::cout << GenericFP::fpconvert<intype>::fpname
+            << " Cases\n"
+            << "Reference Precision: " << refPrec
+            << " bits\n";
+  if(cache) {
+    const unsigned long numCached = std::min<unsigned long>(
+        cache->mappedSize(), numTests);
+    std::cout << "Cached References: " << numCached
+              << " of " << numTests << "\n";
+    cache->save();
+  }
+  arena.printStats();
+  std::cout << "\n\n";
+}
+
+template <unsigned numDPTests>
+void reportTests(
+    NumericTester::NumericTest *(&tests)[numDPTests]) {
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+template <typename intype, unsigned numDPTests>
+void runTests(
+    std::mt19937_64 &engine,
+    NumericTester::NumericTest *(&tests)[numDPTests],
+    const int numTests, const int vecSize,
+    const uint64_t *cacheSeed) {
+  updateTests<intype>(engine, tests, numTests, vecSize,
+                      cacheSeed);
+  reportTests(tests);
+}
+
+void runTests(const int numTests, const int vecSize,
+              const uint64_t *cacheSeed) {
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  NumericTester::NumericTest *floatTests[] = {
       new DPNaiveTest<float>(),
       new DPFMATest<float>(),
       new DPKahanTest<float>(),
       new DPFMAKahanTest<float>(),
+      new DPNeumaierTest<float>(),
+      new DPKleinTest<float>(),
+      new DPNeumaierSIMDTest<float>(),
+      new DPKleinSIMDTest<float>(),
+      new DPFixedDimTest<float, NaiveDotKernel>(),
+      new DPFixedDimTest<float, FMADotKernel>(),
+      new DPFixedDimTest<float, KahanFMADotKernel>(),
       new DPExactFMACompTest<float>(),
       new DPKobbeltTest<float>(),
+      new DPOzakiTest<float>(2),
+      new DPOzakiTest<float>(3),
+      new DPAccSumTest<float>(),
+      new DPFastAccSumTest<float>(),
+      new DPiFastSumTest<float>(),
+      new DPOnlineExactSumTest<float>(),
+      new DPBinnedTest<float>(),
+      new DPSortedTest<float, IncreasingMagnitude<float>>(),
+      new DPSortedTest<float, DecreasingMagnitude<float>>(),
+      new DPSortedTest<float, IncreasingGenus<float>>(),
+      new DPIntervalTest<float>(),
+
+      new DPNaiveTest<float, float, double>(),
+      new DPFMATest<float, float, double>(),
+      new DPKahanTest<float, float, double>(),
+      new DPFMAKahanTest<float, float, double>(),
+      new DPNeumaierTest<float, float, double>(),
+      new DPKleinTest<float, float, double>(),
+      new DPExactFMACompTest<float, float, double>(),
+      new DPKobbeltTest<float, float, double>(),
+
+      new DPNaiveTest<float, double, double>(),
+      new DPFMATest<float, double, double>(),
+      new DPKahanTest<float, double, double>(),
+      new DPFMAKahanTest<float, double, double>(),
+      new DPExactFMACompTest<float, double, double>(),
+      new DPKobbeltTest<float, double, double>()};
+  runTests<float>(engine, floatTests, numTests, vecSize,
+                  cacheSeed);
 
+  NumericTester::NumericTest *doubleTests[] = {
       new DPNaiveTest<double>(),
       new DPFMATest<double>(),
       new DPKahanTest<double>(),
       new DPFMAKahanTest<double>(),
+      new DPNeumaierTest<double>(),
+      new DPKleinTest<double>(),
+      new DPNeumaierSIMDTest<double>(),
+      new DPKleinSIMDTest<double>(),
+      new DPFixedDimTest<double, NaiveDotKernel>(),
+      new DPFixedDimTest<double, FMADotKernel>(),
+      new DPFixedDimTest<double, KahanFMADotKernel>(),
       new DPExactFMACompTest<double>(),
       new DPKobbeltTest<double>(),
+      new DPOzakiTest<double>(2),
+      new DPOzakiTest<double>(3),
+      new DPAccSumTest<double>(),
+      new DPFastAccSumTest<double>(),
+      new DPiFastSumTest<double>(),
+      new DPOnlineExactSumTest<double>(),
+      new DPBinnedTest<double>(),
+      new DPSortedTest<double,
+                       IncreasingMagnitude<double>>(),
+      new DPSortedTest<double,
+                       DecreasingMagnitude<double>>(),
+      new DPSortedTest<double, IncreasingGenus<double>>(),
+      new DPIntervalTest<double>(),
 
-      new DPNaiveTest<long double>(),
-      new DPFMATest<long double>(),
-      new DPKahanTest<long double>(),
-      new DPFMAKahanTest<long double>(),
-      new DPExactFMACompTest<long double>(),
-      new DPKobbeltTest<long double>()};
-  for(int i = 0; i < numTests; i++) {
-    DotProdCase<float> testcase(engine, rgenSign, rgenExp,
-                                rgenMan, vecSize);
-    for(auto t : tests) t->updateStats(testcase);
-  }
+      new DPNaiveTest<double, double, long double>(),
+      new DPFMATest<double, double, long double>(),
+      new DPKahanTest<double, double, long double>(),
+      new DPFMAKahanTest<double, double, long double>(),
+      new DPNeumaierTest<double, double, long double>(),
+      new DPKleinTest<double, double, long double>(),
+      new DPExactFMACompTest<double, double,
+                             long double>(),
+      new DPKobbeltTest<double, double, long double>(),
+
+      new DPNaiveTest<double, double, DoubleDouble>(),
+      new DPFMATest<double, double, DoubleDouble>(),
+      new DPKahanTest<double, double, DoubleDouble>(),
+      new DPFMAKahanTest<double, double, DoubleDouble>(),
+      new DPExactFMACompTest<double, double,
+                             DoubleDouble>(),
+      new DPKobbeltTest<double, double, DoubleDouble>()};
+  runTests<double>(engine, doubleTests, numTests, vecSize,
+                   cacheSeed);
+}
+
+double toSeconds(struct timespec time) {
+  return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/* The first test is the baseline the overhead of the
+ * others is reported against
+ */
+template <typename fptype>
+void runReproTests(std::mt19937_64 &engine,
+                   const int numTests, const int vecSize,
+                   const int numThreads,
+                   const uint64_t *cacheSeed) {
+  NumericTester::NumericTest *tests[] = {
+      new DPNaiveTest<fptype>(), new DPBinnedTest<fptype>(),
+      new DPReproducibilityTest<fptype>(numThreads)};
+  /* The overhead compares elapsed times */
+  for(auto t : tests) t->useWallClock();
+  updateTests<fptype>(engine, tests, numTests, vecSize,
+                      cacheSeed);
+  const double baseline =
+      toSeconds(tests[0]->totalRunTime());
   for(auto t : tests) {
-    t->printStats();
-    std::cout << "\n\n";
-    std::string fname = t->testName().append(".csv");
-    std::ofstream results(fname, std::ios::out);
-    t->dumpData(results);
-    delete t;
+    std::cout << t->testName() << " Overhead: "
+              << toSeconds(t->totalRunTime()) / baseline
+              << "x\n";
   }
+  std::cout << "\n";
+  reportTests(tests);
+}
+
+void runReproTests(const int numTests, const int vecSize,
+                   const int numThreads,
+                   const uint64_t *cacheSeed) {
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  runReproTests<float>(engine, numTests, vecSize,
+                       numThreads, cacheSeed);
+  runReproTests<double>(engine, numTests, vecSize,
+                        numThreads, cacheSeed);
 }
@@ -0,0 +1,103 @@
+
+#ifndef _DOUBLEDOUBLE_HPP_
+#define _DOUBLEDOUBLE_HPP_
+
+#include <array>
+#include <cfloat>
+
+#include "accurate_math.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+
+/* An unevaluated sum of two doubles, hi + lo,
+ * with |lo| <= ulp(hi) / 2.
+ * This gives about 106 bits of precision at roughly
+ * ten times the cost of a double, which makes it a
+ * useful accumulator between long double and MPFR.
+ */
+class DoubleDouble {
+ public:
+  DoubleDouble() : hi(0.0), lo(0.0) {}
+  DoubleDouble(double val) : hi(val), lo(0.0) {}
+  DoubleDouble(double hiVal, double loVal) {
+    std::array<double, 2> sum = twoSum(hiVal, loVal);
+    hi = sum[0];
+    lo = sum[1];
+  }
+
+  explicit operator mpfr::mpreal() const {
+    mpfr::mpreal val(hi);
+    val += lo;
+    return val;
+  }
+
+  DoubleDouble operator-() const {
+    DoubleDouble neg;
+    neg.hi = -hi;
+    neg.lo = -lo;
+    return neg;
+  }
+
+  DoubleDouble &operator+=(const DoubleDouble &rhs) {
+    std::array<double, 2> high = twoSum(hi, rhs.hi);
+    std::array<double, 2> low = twoSum(lo, rhs.lo);
+    high[1] += low[0];
+    high = twoSum(high[0], high[1]);
+    high[1] += low[1];
+    *this = DoubleDouble(high[0], high[1]);
+    return *this;
+  }
+
+  DoubleDouble &operator-=(const DoubleDouble &rhs) {
+    return *this += -rhs;
+  }
+
+  DoubleDouble &operator*=(const DoubleDouble &rhs) {
+    std::array<double, 2> prod = twoProd(hi, rhs.hi);
+    prod[1] = std::fma(hi, rhs.lo, prod[1]);
+    prod[1] = std::fma(lo, rhs.hi, prod[1]);
+    *this = DoubleDouble(prod[0], prod[1]);
+    return *this;
+  }
+
+  double hi, lo;
+};
+
+inline DoubleDouble operator+(DoubleDouble lhs,
+                              const DoubleDouble &rhs) {
+  return lhs += rhs;
+}
+
+inline DoubleDouble operator-(DoubleDouble lhs,
+                              const DoubleDouble &rhs) {
+  return lhs -= rhs;
+}
+
+inline DoubleDouble operator*(DoubleDouble lhs,
+                              const DoubleDouble &rhs) {
+  return lhs *= rhs;
+}
+
+/* Not fused; the product is formed in double-double,
+ * which is already exact for double inputs
+ */
+inline DoubleDouble fma(const DoubleDouble &a,
+                        const DoubleDouble &b,
+                        const DoubleDouble &c) {
+  return a * b + c;
+}
+
+namespace GenericFP {
+/* Only the naming and precision information applies;
+ * there is no hardware bit layout to convert to
+ */
+template <>
+struct fpconvert<DoubleDouble> {
+  static constexpr const double epsilon =
+      DBL_EPSILON * DBL_EPSILON;
+  static constexpr const char *fpname =
+      "Double-Double Precision";
+};
+}
+
+#endif
@@ -0,0 +1,318 @@
+
+#ifndef _FAITHFUL_SUM_HPP_
+#define _FAITHFUL_SUM_HPP_
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "genericfp.hpp"
+
+/* Summation algorithms which guarantee a faithfully or
+ * correctly rounded result, at a cost which adapts to the
+ * condition number of the sum.
+ * Unlike the compensated sums in accurate_math.hpp,
+ * these overwrite the summands with their residuals,
+ * so callers must pass a scratch copy.
+ */
+
+/* The unit roundoff, half of the machine epsilon */
+template <typename fptype>
+constexpr fptype unitRoundoff() {
+  return GenericFP::fpconvert<fptype>::epsilon / 2;
+}
+
+/* The unit in the first place: the largest power of 2
+ * not larger than |val|, or 0 for val = 0
+ */
+template <typename fptype>
+fptype ufp(fptype val) {
+  if(val == 0.0) return 0.0;
+  int exp;
+  std::frexp(val, &exp);
+  return std::ldexp(fptype(1.0), exp - 1);
+}
+
+/* The smallest power of 2 not smaller than |val| */
+template <typename fptype>
+fptype nextPowerTwo(fptype val) {
+  fptype floorPow = ufp(val);
+  if(floorPow == std::fabs(val)) return floorPow;
+  return 2 * floorPow;
+}
+
+/* Splits each summand into the part which is a multiple
+ * of ulp(sigma) and the remainder.
+ * The high parts are summed exactly,
+ * and the remainders replace the summands
+ */
+template <typename fptype>
+fptype extractVector(fptype sigma, fptype *summands,
+                     unsigned size) {
+  fptype tau = 0.0;
+  for(unsigned i = 0; i < size; i++) {
+    fptype q = (sigma + summands[i]) - sigma;
+    summands[i] -= q;
+    tau += q;
+  }
+  return tau;
+}
+
+template <typename fptype>
+fptype iFastSum(fptype *summands, unsigned size);
+
+/* Rump, Ogita, and Oishi's AccSum.
+ * Returns the faithfully rounded sum.
+ * The error-free extraction requires
+ * size + 2 <= 2^(precision / 2); longer sums are correctly
+ * rounded with iFastSum instead
+ */
+template <typename fptype>
+fptype accSum(fptype *summands, unsigned size) {
+  constexpr const fptype eps = unitRoundoff<fptype>();
+  const fptype mS = nextPowerTwo(fptype(size + 2));
+  if(mS * mS * eps > 1.0) return iFastSum(summands, size);
+  fptype mu = 0.0;
+  for(unsigned i = 0; i < size; i++)
+    mu = std::fmax(mu, std::fabs(summands[i]));
+  if(size == 0 || mu == 0.0) return 0.0;
+  fptype sigma = mS * nextPowerTwo(mu);
+  const fptype phi = eps * mS;
+  const fptype factor = 2 * eps * mS * mS;
+  fptype t = 0.0;
+  for(;;) {
+    fptype tau = extractVector(sigma, summands, size);
+    fptype tau1 = t + tau;
+    if(std::fabs(tau1) >= factor * sigma ||
+       sigma <= std::numeric_limits<fptype>::min()) {
+      fptype tau2 = tau - (tau1 - t);
+      fptype remainder = 0.0;
+      for(unsigned i = 0; i < size; i++)
+        remainder += summands[i];
+      return tau1 + (tau2 + remainder);
+    }
+    t = tau1;
+    /* The leading parts cancelled exactly,
+     * so start over on what remains
+     */
+    if(t == 0.0) return accSum(summands, size);
+    sigma *= phi;
+  }
+}
+
+/* Rump's FastAccSum.
+ * Like AccSum this returns the faithfully rounded sum,
+ * but the extraction unit comes from a running sum rather
+ * than the maximum magnitude, saving a pass over the data.
+ * It requires 4 (size + 2)^2 eps <= 1; like AccSum, longer
+ * sums fall back to iFastSum
+ */
+template <typename fptype>
+fptype fastAccSum(fptype *summands, unsigned size) {
+  constexpr const fptype eps = unitRoundoff<fptype>();
+  /* Sums of multiples of the smallest subnormal which are
+   * below this are exact
+   */
+  constexpr const fptype underflowBound =
+      std::numeric_limits<fptype>::denorm_min() / eps;
+  const fptype n = size;
+  if(4 * (n + 2) * (n + 2) * eps > 1.0)
+    return iFastSum(summands, size);
+  fptype absSum = 0.0;
+  for(unsigned i = 0; i < size; i++)
+    absSum += std::fabs(summands[i]);
+  fptype bound = absSum / (1 - n * eps);
+  if(bound <= underflowBound) {
+    /* Every partial sum is exact */
+    fptype sum = 0.0;
+    for(unsigned i = 0; i < size; i++) sum += summands[i];
+    return sum;
+  }
+  fptype t = 0.0, tPrime = 0.0, tau = 0.0;
+  for(;;) {
+    const fptype sigma0 =
+        (2 * bound) / (1 - (3 * n + 1) * eps);
+    fptype sigma = sigma0;
+    for(unsigned i = 0; i < size; i++) {
+      fptype sigmaNext = sigma + summands[i];
+      fptype q = sigmaNext - sigma;
+      summands[i] -= q;
+      sigma = sigmaNext;
+    }
+    tau = sigma - sigma0;
+    t = tPrime;
+    tPrime = t + tau;
+    if(tPrime == 0.0) return fastAccSum(summands, size);
+    const fptype u = ufp(sigma0);
+    const fptype Phi =
+        ((2 * n * (n + 2) * eps) * u) / (1 - 5 * eps);
+    bound = std::fmin(
+        (fptype(1.5) + 4 * eps) * (n * eps) * sigma0,
+        2 * n * eps * u);
+    if(std::fabs(tPrime) >= Phi ||
+       4 * bound <= underflowBound)
+      break;
+  }
+  fptype tau2 = (t - tPrime) + tau;
+  fptype remainder = 0.0;
+  for(unsigned i = 0; i < size; i++)
+    remainder += summands[i];
+  return tPrime + (tau2 + remainder);
+}
+
+/* Zhu and Hayes' iFastSum, which returns the correctly
+ * rounded sum.
+ * Each pass distills the summands into a running sum and
+ * the nonzero rounding errors, bounding what is left.
+ * The pass ends once the bound shows that no rounding
+ * boundary of the running sum can be crossed.
+ * This bounds the leftover errors by their magnitudes
+ * rather than by the partial sums, and replaces the
+ * paper's Round3 with an explicit midpoint check against
+ * the neighbouring floating point value.
+ */
+template <typename fptype>
+fptype iFastSum(fptype *summands, unsigned size) {
+  constexpr const fptype eps = unitRoundoff<fptype>();
+  constexpr const fptype inf =
+      std::numeric_limits<fptype>::infinity();
+  if(size == 0) return 0.0;
+  fptype s = 0.0;
+  for(unsigned i = 0; i < size; i++) {
+    std::array<fptype, 2> sum = twoSum(s, summands[i]);
+    s = sum[0];
+    summands[i] = sum[1];
+  }
+  for(;;) {
+    /* Each pass starts from 0, so the first addition is
+     * exact and there is always room to append st
+     */
+    unsigned count = 0;
+    fptype st = 0.0;
+    fptype em = 0.0;
+    for(unsigned i = 0; i < size; i++) {
+      std::array<fptype, 2> sum = twoSum(st, summands[i]);
+      st = sum[0];
+      if(sum[1] != 0.0) {
+        summands[count] = sum[1];
+        count++;
+        em += std::fabs(sum[1]);
+      }
+    }
+    /* Bounds the sum of the errors left in summands,
+     * accounting for the rounding in computing it
+     */
+    em *= 1 + 2 * count * eps;
+    std::array<fptype, 2> sum = twoSum(s, st);
+    s = sum[0];
+    st = sum[1];
+    summands[count] = st;
+    size = count + 1;
+    /* The true sum is s + st + (what's left),
+     * and s is the correctly rounded value of s + st
+     */
+    if(em == 0.0) return s;
+    if(s == 0.0) continue;
+    /* The distances to the midpoints with the neighbouring
+     * values, which differ when s is a power of 2
+     */
+    const fptype upMid = (std::nextafter(s, inf) - s) / 2;
+    const fptype downMid =
+        (s - std::nextafter(s, -inf)) / 2;
+    if(em < (upMid - st) * (1 - 4 * eps) &&
+       em < (downMid + st) * (1 - 4 * eps))
+      return s;
+    if((st == upMid && em < upMid * (1 - 4 * eps)) ||
+       (-st == downMid && em < downMid * (1 - 4 * eps))) {
+      /* s + st is exactly halfway to the next value,
+       * and what's left is too small to reach any other
+       * midpoint, so its sign decides the rounding
+       */
+      fptype rest = iFastSum(summands, count);
+      if((rest > 0.0) == (st > 0.0) && rest != 0.0)
+        return std::nextafter(s, st * inf);
+      return s;
+    }
+  }
+}
+
+/* Zhu and Hayes' OnlineExactSum.
+ * Summands are accumulated into a pair of accumulators
+ * indexed by their exponent, which keeps each addition
+ * exact up to a known number of summands, after which
+ * the accumulators are redistributed.
+ * The correctly rounded sum of the at most
+ * 2 * (exponent count) nonzero accumulators is computed
+ * with iFastSum.
+ */
+template <typename fptype>
+class OnlineExactSum {
+ public:
+  OnlineExactSum() : primary(), secondary(), scratch() {
+    reset();
+  }
+
+  void reset() {
+    primary.assign(numExps, 0.0);
+    secondary.assign(numExps, 0.0);
+    sinceCompaction = 0;
+  }
+
+  void add(fptype val) {
+    if(sinceCompaction >= compactionPeriod) compact();
+    accumulate(primary, secondary, val);
+    sinceCompaction++;
+  }
+
+  fptype result() {
+    scratch.clear();
+    for(unsigned i = 0; i < numExps; i++) {
+      if(primary[i] != 0.0) scratch.push_back(primary[i]);
+      if(secondary[i] != 0.0)
+        scratch.push_back(secondary[i]);
+    }
+    return iFastSum(scratch.data(), scratch.size());
+  }
+
+ private:
+  static constexpr const unsigned numExps =
+      GenericFP::fpconvert<fptype>::infExp + 1;
+  /* The secondary accumulators are exact for up to
+   * 2^(precision / 2) additions.
+   * Compacting adds up to 2 * numExps values,
+   * so leave room for those
+   */
+  static constexpr const unsigned compactionPeriod =
+      1u << (GenericFP::fpconvert<fptype>::precision / 2 -
+             1);
+
+  static void accumulate(std::vector<fptype> &primAcc,
+                         std::vector<fptype> &secAcc,
+                         fptype val) {
+    unsigned exp = GenericFP::gfFPStruct(val).exponent;
+    std::array<fptype, 2> sum = twoSum(primAcc[exp], val);
+    primAcc[exp] = sum[0];
+    secAcc[exp] += sum[1];
+  }
+
+  void compact() {
+    std::vector<fptype> newPrimary(numExps, 0.0);
+    std::vector<fptype> newSecondary(numExps, 0.0);
+    for(unsigned i = 0; i < numExps; i++) {
+      accumulate(newPrimary, newSecondary, primary[i]);
+      accumulate(newPrimary, newSecondary, secondary[i]);
+    }
+    primary.swap(newPrimary);
+    secondary.swap(newSecondary);
+    sinceCompaction = 0;
+  }
+
+  std::vector<fptype> primary;
+  std::vector<fptype> secondary;
+  std::vector<fptype> scratch;
+  unsigned sinceCompaction;
+};
+
+#endif
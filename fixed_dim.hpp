@@ -0,0 +1,82 @@
+
+#ifndef _FIXED_DIM_HPP_
+#define _FIXED_DIM_HPP_
+
+#include <cmath>
+
+/* Dot product kernels specialized on the dimension.
+ * A kernel's dotProd<fixedDim> loops over fixedDim
+ * elements, so the loop can be fully unrolled and the
+ * terms kept in registers, or over the runtime dim when
+ * fixedDim is 0.
+ * fixedDimDotProd dispatches on the runtime dimension, as
+ * code which instantiates the small sizes it uses would,
+ * and falls back to the generic loop for other sizes.
+ * Every specialization sums in the same order as the
+ * generic loop, so their results are identical
+ */
+
+struct NaiveDotKernel {
+  static constexpr const char *name = "Naive";
+  template <unsigned fixedDim, typename fptype>
+  static fptype dotProd(const fptype *vec1,
+                        const fptype *vec2, unsigned dim) {
+    const unsigned size = fixedDim != 0 ? fixedDim : dim;
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < size; i++)
+      accumulator += vec1[i] * vec2[i];
+    return accumulator;
+  }
+};
+
+struct FMADotKernel {
+  static constexpr const char *name = "FMA";
+  template <unsigned fixedDim, typename fptype>
+  static fptype dotProd(const fptype *vec1,
+                        const fptype *vec2, unsigned dim) {
+    const unsigned size = fixedDim != 0 ? fixedDim : dim;
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < size; i++)
+      accumulator = std::fma(vec1[i], vec2[i], accumulator);
+    return accumulator;
+  }
+};
+
+struct KahanFMADotKernel {
+  static constexpr const char *name = "Kahan FMA";
+  template <unsigned fixedDim, typename fptype>
+  static fptype dotProd(const fptype *vec1,
+                        const fptype *vec2, unsigned dim) {
+    const unsigned size = fixedDim != 0 ? fixedDim : dim;
+    fptype accumulator = 0.0;
+    fptype c = 0.0;
+    for(unsigned i = 0; i < size; i++) {
+      fptype mod = std::fma(vec1[i], vec2[i], -c);
+      fptype tmp = accumulator + mod;
+      c = (tmp - accumulator) - mod;
+      accumulator = tmp;
+    }
+    return accumulator;
+  }
+};
+
+template <typename kernel, typename fptype>
+fptype fixedDimDotProd(const fptype *vec1,
+                       const fptype *vec2, unsigned dim) {
+  switch(dim) {
+    case 2:
+      return kernel::template dotProd<2>(vec1, vec2, dim);
+    case 3:
+      return kernel::template dotProd<3>(vec1, vec2, dim);
+    case 4:
+      return kernel::template dotProd<4>(vec1, vec2, dim);
+    case 8:
+      return kernel::template dotProd<8>(vec1, vec2, dim);
+    case 16:
+      return kernel::template dotProd<16>(vec1, vec2, dim);
+    default:
+      return kernel::template dotProd<0>(vec1, vec2, dim);
+  }
+}
+
+#endif
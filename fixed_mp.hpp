@@ -0,0 +1,130 @@
+
+#ifndef _FIXED_MP_HPP_
+#define _FIXED_MP_HPP_
+
+#include "mpreal.h"
+
+/* A multiprecision float with Bits bits of precision known
+ * at compile time, and its limbs stored inline, so it can
+ * live on the stack or in a vector without touching the
+ * heap.
+ * Arithmetic goes through MPFR's custom interface, so every
+ * operation is correctly rounded to Bits bits, and exact
+ * whenever the result fits.
+ * The mpfr_t points into the object, so copies must go
+ * through the copy operations, which re-point it
+ */
+template <unsigned Bits>
+class FixedMP {
+ public:
+  static constexpr const unsigned bits = Bits;
+
+  FixedMP() {
+    init();
+    mpfr_set_zero(value, 1);
+  }
+
+  /* Exact when Bits is at least the precision of val;
+   * explicit, so a narrower FixedMP can't round a value
+   * silently
+   */
+  explicit FixedMP(double val) {
+    init();
+    mpfr_set_d(value, val, MPFR_RNDN);
+  }
+
+  explicit FixedMP(long double val) {
+    init();
+    mpfr_set_ld(value, val, MPFR_RNDN);
+  }
+
+  explicit FixedMP(const mpfr::mpreal &val) {
+    init();
+    mpfr_set(value, val.mpfr_srcptr(), MPFR_RNDN);
+  }
+
+  FixedMP(const FixedMP &other) {
+    init();
+    mpfr_set(value, other.value, MPFR_RNDN);
+  }
+
+  FixedMP &operator=(const FixedMP &other) {
+    mpfr_set(value, other.value, MPFR_RNDN);
+    return *this;
+  }
+
+  /* Converts with Bits bits of precision */
+  mpfr::mpreal toMPReal() const {
+    return mpfr::mpreal(value);
+  }
+
+  FixedMP &operator+=(const FixedMP &rhs) {
+    mpfr_add(value, value, rhs.value, MPFR_RNDN);
+    return *this;
+  }
+
+  FixedMP &operator-=(const FixedMP &rhs) {
+    mpfr_sub(value, value, rhs.value, MPFR_RNDN);
+    return *this;
+  }
+
+  FixedMP &operator*=(const FixedMP &rhs) {
+    mpfr_mul(value, value, rhs.value, MPFR_RNDN);
+    return *this;
+  }
+
+  /* Adds lhs * rhs with a single rounding; the factors may
+   * be narrower, as for exact products of fptype values
+   */
+  template <unsigned FactorBits>
+  FixedMP &addProduct(const FixedMP<FactorBits> &lhs,
+                      const FixedMP<FactorBits> &rhs) {
+    mpfr_fma(value, lhs.mpfr_srcptr(), rhs.mpfr_srcptr(),
+             value, MPFR_RNDN);
+    return *this;
+  }
+
+  static FixedMP fma(const FixedMP &a, const FixedMP &b,
+                     const FixedMP &c) {
+    FixedMP result;
+    mpfr_fma(result.value, a.value, b.value, c.value,
+             MPFR_RNDN);
+    return result;
+  }
+
+  ::mpfr_ptr mpfr_ptr() { return value; }
+  ::mpfr_srcptr mpfr_srcptr() const { return value; }
+
+ private:
+  static constexpr const unsigned numLimbs =
+      (Bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+
+  void init() {
+    mpfr_custom_init(limbs, Bits);
+    mpfr_custom_init_set(value, MPFR_ZERO_KIND, 0, Bits,
+                         limbs);
+  }
+
+  mp_limb_t limbs[numLimbs];
+  mpfr_t value;
+};
+
+template <unsigned Bits>
+FixedMP<Bits> operator+(FixedMP<Bits> lhs,
+                        const FixedMP<Bits> &rhs) {
+  return lhs += rhs;
+}
+
+template <unsigned Bits>
+FixedMP<Bits> operator-(FixedMP<Bits> lhs,
+                        const FixedMP<Bits> &rhs) {
+  return lhs -= rhs;
+}
+
+template <unsigned Bits>
+FixedMP<Bits> operator*(FixedMP<Bits> lhs,
+                        const FixedMP<Bits> &rhs) {
+  return lhs *= rhs;
+}
+
+#endif
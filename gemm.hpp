@@ -0,0 +1,214 @@
+
+#ifndef _GEMM_HPP_
+#define _GEMM_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "accurate_math.hpp"
+
+/* Matrix-vector and matrix-matrix products.
+ * All matrices are stored row major; A is rows x inner,
+ * and B is inner x cols, or a vector of length inner.
+ * The blocked kernels form the products of each block of
+ * the inner dimension into zeroed accumulators and then
+ * add them to the result, as register blocked BLAS
+ * kernels do, so blocking changes the summation order.
+ * The compensated kernels accumulate every entry with
+ * Dot2, which is independent of the blocking
+ */
+
+template <typename fptype>
+void naiveGEMV(const fptype *a, const fptype *x, fptype *y,
+               unsigned rows, unsigned inner) {
+  for(unsigned i = 0; i < rows; i++) {
+    fptype accumulator = 0.0;
+    for(unsigned k = 0; k < inner; k++)
+      accumulator += a[i * inner + k] * x[k];
+    y[i] = accumulator;
+  }
+}
+
+/* The number of rows of A whose products are accumulated
+ * together in registers, sharing the loads of x
+ */
+constexpr const unsigned gemvRowBlock = 4;
+
+template <typename fptype>
+void blockedGEMV(const fptype *a, const fptype *x,
+                 fptype *y, unsigned rows, unsigned inner,
+                 unsigned kBlock = 256) {
+  std::fill(y, y + rows, fptype(0.0));
+  for(unsigned kb = 0; kb < inner; kb += kBlock) {
+    const unsigned kEnd = std::min(kb + kBlock, inner);
+    unsigned i = 0;
+    for(; i + gemvRowBlock <= rows; i += gemvRowBlock) {
+      fptype partial[gemvRowBlock] = {};
+      for(unsigned k = kb; k < kEnd; k++) {
+        const fptype xk = x[k];
+        for(unsigned r = 0; r < gemvRowBlock; r++)
+          partial[r] += a[(i + r) * inner + k] * xk;
+      }
+      for(unsigned r = 0; r < gemvRowBlock; r++)
+        y[i + r] += partial[r];
+    }
+    for(; i < rows; i++) {
+      fptype partial = 0.0;
+      for(unsigned k = kb; k < kEnd; k++)
+        partial += a[i * inner + k] * x[k];
+      y[i] += partial;
+    }
+  }
+}
+
+/* The same blocking as blockedGEMV, with each row's sum
+ * kept in y and its error term carried across the blocks
+ * of the inner dimension, so the result doesn't depend on
+ * kBlock
+ */
+template <typename fptype>
+void compensatedGEMV(const fptype *a, const fptype *x,
+                     fptype *y, unsigned rows,
+                     unsigned inner,
+                     unsigned kBlock = 256) {
+  std::fill(y, y + rows, fptype(0.0));
+  std::vector<fptype> err(rows, 0.0);
+  for(unsigned kb = 0; kb < inner; kb += kBlock) {
+    const unsigned kEnd = std::min(kb + kBlock, inner);
+    unsigned i = 0;
+    for(; i + gemvRowBlock <= rows; i += gemvRowBlock) {
+      fptype sum[gemvRowBlock], c[gemvRowBlock];
+      for(unsigned r = 0; r < gemvRowBlock; r++) {
+        sum[r] = y[i + r];
+        c[r] = err[i + r];
+      }
+      for(unsigned k = kb; k < kEnd; k++) {
+        const fptype xk = x[k];
+        for(unsigned r = 0; r < gemvRowBlock; r++) {
+          const fptype aik = a[(i + r) * inner + k];
+          const fptype prod = aik * xk;
+          c[r] += std::fma(aik, xk, -prod);
+          neumaierAddBranchFree(sum[r], c[r], prod);
+        }
+      }
+      for(unsigned r = 0; r < gemvRowBlock; r++) {
+        y[i + r] = sum[r];
+        err[i + r] = c[r];
+      }
+    }
+    for(; i < rows; i++) {
+      fptype sum = y[i], c = err[i];
+      for(unsigned k = kb; k < kEnd; k++) {
+        const fptype prod = a[i * inner + k] * x[k];
+        c += std::fma(a[i * inner + k], x[k], -prod);
+        neumaierAddBranchFree(sum, c, prod);
+      }
+      y[i] = sum;
+      err[i] = c;
+    }
+  }
+  for(unsigned i = 0; i < rows; i++) y[i] += err[i];
+}
+
+template <typename fptype>
+void naiveGEMM(const fptype *a, const fptype *b, fptype *c,
+               unsigned rows, unsigned cols,
+               unsigned inner) {
+  for(unsigned i = 0; i < rows; i++) {
+    for(unsigned j = 0; j < cols; j++) {
+      fptype accumulator = 0.0;
+      for(unsigned k = 0; k < inner; k++)
+        accumulator += a[i * inner + k] * b[k * cols + j];
+      c[i * cols + j] = accumulator;
+    }
+  }
+}
+
+/* The tile is the partial product of a block of A and a
+ * block of B, kept small enough to stay in cache.
+ * The j loop is innermost so it runs over contiguous
+ * rows of B and the tile
+ */
+template <typename fptype, unsigned blockSize = 32>
+void blockedGEMM(const fptype *a, const fptype *b,
+                 fptype *c, unsigned rows, unsigned cols,
+                 unsigned inner) {
+  std::fill(c, c + rows * cols, fptype(0.0));
+  fptype tile[blockSize * blockSize];
+  for(unsigned ib = 0; ib < rows; ib += blockSize) {
+    const unsigned iEnd = std::min(ib + blockSize, rows);
+    for(unsigned jb = 0; jb < cols; jb += blockSize) {
+      const unsigned jEnd = std::min(jb + blockSize, cols);
+      const unsigned width = jEnd - jb;
+      for(unsigned kb = 0; kb < inner; kb += blockSize) {
+        const unsigned kEnd =
+            std::min(kb + blockSize, inner);
+        std::fill(tile, tile + blockSize * width,
+                  fptype(0.0));
+        for(unsigned i = ib; i < iEnd; i++) {
+          fptype *tileRow = tile + (i - ib) * width;
+          for(unsigned k = kb; k < kEnd; k++) {
+            const fptype aik = a[i * inner + k];
+            const fptype *bRow = b + k * cols + jb;
+            for(unsigned j = 0; j < width; j++)
+              tileRow[j] += aik * bRow[j];
+          }
+        }
+        for(unsigned i = ib; i < iEnd; i++) {
+          const fptype *tileRow = tile + (i - ib) * width;
+          fptype *cRow = c + i * cols + jb;
+          for(unsigned j = 0; j < width; j++)
+            cRow[j] += tileRow[j];
+        }
+      }
+    }
+  }
+}
+
+/* The same tiling as blockedGEMM, with a sum and an error
+ * term per entry of the tile carried across the blocks of
+ * the inner dimension
+ */
+template <typename fptype, unsigned blockSize = 32>
+void compensatedGEMM(const fptype *a, const fptype *b,
+                     fptype *c, unsigned rows,
+                     unsigned cols, unsigned inner) {
+  fptype sum[blockSize * blockSize];
+  fptype err[blockSize * blockSize];
+  for(unsigned ib = 0; ib < rows; ib += blockSize) {
+    const unsigned iEnd = std::min(ib + blockSize, rows);
+    for(unsigned jb = 0; jb < cols; jb += blockSize) {
+      const unsigned jEnd = std::min(jb + blockSize, cols);
+      const unsigned width = jEnd - jb;
+      std::fill(sum, sum + blockSize * width, fptype(0.0));
+      std::fill(err, err + blockSize * width, fptype(0.0));
+      for(unsigned kb = 0; kb < inner; kb += blockSize) {
+        const unsigned kEnd =
+            std::min(kb + blockSize, inner);
+        for(unsigned i = ib; i < iEnd; i++) {
+          fptype *sumRow = sum + (i - ib) * width;
+          fptype *errRow = err + (i - ib) * width;
+          for(unsigned k = kb; k < kEnd; k++) {
+            const fptype aik = a[i * inner + k];
+            const fptype *bRow = b + k * cols + jb;
+            for(unsigned j = 0; j < width; j++) {
+              const fptype prod = aik * bRow[j];
+              errRow[j] += std::fma(aik, bRow[j], -prod);
+              neumaierAddBranchFree(sumRow[j], errRow[j],
+                                    prod);
+            }
+          }
+        }
+      }
+      for(unsigned i = ib; i < iEnd; i++) {
+        for(unsigned j = 0; j < width; j++) {
+          c[i * cols + jb + j] = sum[(i - ib) * width + j] +
+                                 err[(i - ib) * width + j];
+        }
+      }
+    }
+  }
+}
+
+#endif
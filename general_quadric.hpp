@@ -0,0 +1,311 @@
+
+#ifndef _GENERAL_QUADRIC_HPP_
+#define _GENERAL_QUADRIC_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "simd.hpp"
+
+/* A general quadric surface, the points p where
+ *   Q(p) = (p, 1)^T M (p, 1) = 0
+ * for a symmetric 4x4 matrix M.
+ * This is stored as the 10 coefficients of the polynomial
+ *   Q = xx x^2 + yy y^2 + zz z^2 + xy x y + yz y z +
+ *       xz x z + x x + y y + z z + 1,
+ * in that order, so the off diagonal entries of M are
+ * doubled
+ */
+template <typename fptype>
+struct GeneralQuadric {
+  static constexpr const unsigned numCoeffs = 10;
+  enum Coeff { xx, yy, zz, xy, yz, xz, x, y, z, one };
+
+  GeneralQuadric() : coeffs() {}
+
+  template <typename mattype>
+  static GeneralQuadric fromMatrix(
+      const mattype (&m)[4][4]) {
+    GeneralQuadric quadric;
+    quadric.coeffs[xx] = fptype(m[0][0]);
+    quadric.coeffs[yy] = fptype(m[1][1]);
+    quadric.coeffs[zz] = fptype(m[2][2]);
+    quadric.coeffs[xy] = fptype(2 * m[0][1]);
+    quadric.coeffs[yz] = fptype(2 * m[1][2]);
+    quadric.coeffs[xz] = fptype(2 * m[0][2]);
+    quadric.coeffs[x] = fptype(2 * m[0][3]);
+    quadric.coeffs[y] = fptype(2 * m[1][3]);
+    quadric.coeffs[z] = fptype(2 * m[2][3]);
+    quadric.coeffs[one] = fptype(m[3][3]);
+    return quadric;
+  }
+
+  /* The coefficients of the i-th partial derivative,
+   * which is linear:
+   *   dQ/dp_i = row[0] x + row[1] y + row[2] z + row[3]
+   */
+  std::array<fptype, 4> gradientRow(unsigned i) const {
+    const unsigned index[3][4] = {{xx, xy, xz, x},
+                                  {xy, yy, yz, y},
+                                  {xz, yz, zz, z}};
+    std::array<fptype, 4> row;
+    for(unsigned j = 0; j < 4; j++)
+      row[j] = coeffs[index[i][j]];
+    row[i] *= 2;
+    return row;
+  }
+
+  fptype coeffs[numCoeffs];
+};
+
+/* The kernels evaluate a vector of points at once, with a
+ * point per lane, in the nested form
+ *   x (xx x + xy y + xz z + x) + y (yy y + yz z + y) +
+ *   z (zz z + z) + 1
+ */
+
+struct NaiveQuadricKernel {
+  static constexpr const char *name = "Naive";
+  template <typename fptype, typename vec>
+  static vec evaluate(const GeneralQuadric<fptype> &q,
+                      vec x, vec y, vec z) {
+    using Q = GeneralQuadric<fptype>;
+    const fptype *c = q.coeffs;
+    const vec rowX = c[Q::xx] * x + c[Q::xy] * y +
+                     c[Q::xz] * z + c[Q::x];
+    const vec rowY = c[Q::yy] * y + c[Q::yz] * z + c[Q::y];
+    const vec rowZ = c[Q::zz] * z + c[Q::z];
+    return x * rowX + y * rowY + z * rowZ + c[Q::one];
+  }
+};
+
+struct FMAQuadricKernel {
+  static constexpr const char *name = "FMA";
+  template <typename fptype, typename vec>
+  static vec evaluate(const GeneralQuadric<fptype> &q,
+                      vec x, vec y, vec z) {
+    using Q = GeneralQuadric<fptype>;
+    const fptype *c = q.coeffs;
+    vec rowX = SIMD::fma<fptype>(vec{} + c[Q::xz], z,
+                                 vec{} + c[Q::x]);
+    rowX = SIMD::fma<fptype>(vec{} + c[Q::xy], y, rowX);
+    rowX = SIMD::fma<fptype>(vec{} + c[Q::xx], x, rowX);
+    vec rowY = SIMD::fma<fptype>(vec{} + c[Q::yz], z,
+                                 vec{} + c[Q::y]);
+    rowY = SIMD::fma<fptype>(vec{} + c[Q::yy], y, rowY);
+    const vec rowZ = SIMD::fma<fptype>(vec{} + c[Q::zz], z,
+                                       vec{} + c[Q::z]);
+    vec sum = SIMD::fma<fptype>(z, rowZ, vec{} + c[Q::one]);
+    sum = SIMD::fma<fptype>(y, rowY, sum);
+    return SIMD::fma<fptype>(x, rowX, sum);
+  }
+};
+
+/* The rows are formed as in FMAQuadricKernel, and their
+ * products with the point are accumulated with Kahan's
+ * compensation, as in QuadKahanFMATest
+ */
+struct KahanFMAQuadricKernel {
+  static constexpr const char *name = "Kahan FMA";
+  template <typename fptype, typename vec>
+  static vec evaluate(const GeneralQuadric<fptype> &q,
+                      vec x, vec y, vec z) {
+    using Q = GeneralQuadric<fptype>;
+    const fptype *c = q.coeffs;
+    vec rowX = SIMD::fma<fptype>(vec{} + c[Q::xz], z,
+                                 vec{} + c[Q::x]);
+    rowX = SIMD::fma<fptype>(vec{} + c[Q::xy], y, rowX);
+    rowX = SIMD::fma<fptype>(vec{} + c[Q::xx], x, rowX);
+    vec rowY = SIMD::fma<fptype>(vec{} + c[Q::yz], z,
+                                 vec{} + c[Q::y]);
+    rowY = SIMD::fma<fptype>(vec{} + c[Q::yy], y, rowY);
+    const vec rowZ = SIMD::fma<fptype>(vec{} + c[Q::zz], z,
+                                       vec{} + c[Q::z]);
+    const vec factors[] = {z, y, x};
+    const vec rows[] = {rowZ, rowY, rowX};
+    vec sum = vec{} + c[Q::one];
+    vec comp = {};
+    for(unsigned i = 0; i < 3; i++) {
+      const vec mod =
+          SIMD::fma<fptype>(factors[i], rows[i], -comp);
+      const vec tmp = sum + mod;
+      comp = (tmp - sum) - mod;
+      sum = tmp;
+    }
+    return sum;
+  }
+};
+
+/* Splits every monomial into exact terms with TwoProd,
+ * two for each linear term and four for each quadratic
+ * term, and sums them with iFastSum, so the result is the
+ * correctly rounded value of Q.
+ * The terms are formed for the whole vector, and summed
+ * lane by lane
+ */
+struct ExactQuadricKernel {
+  static constexpr const char *name = "Error Free";
+  template <typename fptype, typename vec>
+  static vec evaluate(const GeneralQuadric<fptype> &q,
+                      vec x, vec y, vec z) {
+    using Q = GeneralQuadric<fptype>;
+    constexpr const unsigned lanes =
+        sizeof(vec) / sizeof(fptype);
+    constexpr const unsigned numTerms = 6 * 4 + 3 * 2 + 1;
+    const fptype *c = q.coeffs;
+    vec terms[numTerms];
+    unsigned numTerm = 0;
+    const unsigned quadratic[][3] = {
+        {Q::xx, 0, 0}, {Q::yy, 1, 1}, {Q::zz, 2, 2},
+        {Q::xy, 0, 1}, {Q::yz, 1, 2}, {Q::xz, 0, 2}};
+    const vec point[] = {x, y, z};
+    for(auto &monomial : quadratic) {
+      std::array<vec, 2> first = twoProdDekker<fptype>(
+          vec{} + c[monomial[0]], point[monomial[1]]);
+      for(unsigned i = 0; i < 2; i++) {
+        std::array<vec, 2> second = twoProdDekker<fptype>(
+            first[i], point[monomial[2]]);
+        terms[numTerm++] = second[0];
+        terms[numTerm++] = second[1];
+      }
+    }
+    const unsigned linear[] = {Q::x, Q::y, Q::z};
+    for(unsigned i = 0; i < 3; i++) {
+      std::array<vec, 2> prod = twoProdDekker<fptype>(
+          vec{} + c[linear[i]], point[i]);
+      terms[numTerm++] = prod[0];
+      terms[numTerm++] = prod[1];
+    }
+    terms[numTerm++] = vec{} + c[Q::one];
+    vec result;
+    fptype laneTerms[numTerms];
+    for(unsigned j = 0; j < lanes; j++) {
+      for(unsigned t = 0; t < numTerms; t++)
+        laneTerms[t] = terms[t][j];
+      result[j] = iFastSum(laneTerms, numTerms);
+    }
+    return result;
+  }
+};
+
+/* The gradient kernels write the three partial derivatives
+ * of a vector of points, with a point per lane.
+ * Far from the origin, and especially near the surface,
+ * the terms of each derivative are much larger than their
+ * sum and cancel
+ */
+
+struct NaiveGradientKernel {
+  static constexpr const char *name = "Naive";
+  template <typename fptype, typename vec>
+  static void gradient(const GeneralQuadric<fptype> &q,
+                       vec x, vec y, vec z,
+                       vec (&grad)[3]) {
+    for(unsigned i = 0; i < 3; i++) {
+      const std::array<fptype, 4> r = q.gradientRow(i);
+      grad[i] = r[0] * x + r[1] * y + r[2] * z + r[3];
+    }
+  }
+};
+
+struct FMAGradientKernel {
+  static constexpr const char *name = "FMA";
+  template <typename fptype, typename vec>
+  static void gradient(const GeneralQuadric<fptype> &q,
+                       vec x, vec y, vec z,
+                       vec (&grad)[3]) {
+    for(unsigned i = 0; i < 3; i++) {
+      const std::array<fptype, 4> r = q.gradientRow(i);
+      vec g = SIMD::fma<fptype>(vec{} + r[2], z,
+                                vec{} + r[3]);
+      g = SIMD::fma<fptype>(vec{} + r[1], y, g);
+      grad[i] = SIMD::fma<fptype>(vec{} + r[0], x, g);
+    }
+  }
+};
+
+/* Every derivative is a dot product with the point,
+ * computed with Ogita, Rump, and Oishi's Dot2, so it is as
+ * accurate as if it were computed with twice the precision
+ * and then rounded
+ */
+struct CompensatedGradientKernel {
+  static constexpr const char *name = "Compensated";
+  template <typename fptype, typename vec>
+  static void gradient(const GeneralQuadric<fptype> &q,
+                       vec x, vec y, vec z,
+                       vec (&grad)[3]) {
+    const vec point[] = {x, y, z};
+    for(unsigned i = 0; i < 3; i++) {
+      const std::array<fptype, 4> r = q.gradientRow(i);
+      vec sum = vec{} + r[3];
+      vec err = {};
+      for(unsigned j = 0; j < 3; j++) {
+        std::array<vec, 2> prod =
+            twoProdDekker<fptype>(vec{} + r[j], point[j]);
+        std::array<vec, 2> partial =
+            twoSumBranchFree(sum, prod[0]);
+        sum = partial[0];
+        err += prod[1] + partial[1];
+      }
+      grad[i] = sum + err;
+    }
+  }
+};
+
+/* Writes the unit normals, the normalized gradients, at
+ * count points.
+ * The normalization is the same for every kernel, so the
+ * normals only differ in the accuracy of the gradient
+ */
+template <typename kernel, typename fptype>
+void quadricNormals(const GeneralQuadric<fptype> &quadric,
+                    const fptype *x, const fptype *y,
+                    const fptype *z, fptype *nx,
+                    fptype *ny, fptype *nz,
+                    unsigned count) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    vec grad[3];
+    kernel::template gradient<fptype>(
+        quadric, SIMD::loadPartial(x + j, width),
+        SIMD::loadPartial(y + j, width),
+        SIMD::loadPartial(z + j, width), grad);
+    const vec length = SIMD::sqrt<fptype>(
+        grad[0] * grad[0] + grad[1] * grad[1] +
+        grad[2] * grad[2]);
+    SIMD::storePartial(nx + j, grad[0] / length, width);
+    SIMD::storePartial(ny + j, grad[1] / length, width);
+    SIMD::storePartial(nz + j, grad[2] / length, width);
+  }
+}
+
+/* Evaluates the quadric at count points, stored as an
+ * array per coordinate
+ */
+template <typename kernel, typename fptype>
+void evaluateQuadric(const GeneralQuadric<fptype> &quadric,
+                     const fptype *x, const fptype *y,
+                     const fptype *z, fptype *values,
+                     unsigned count) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    const vec val = kernel::template evaluate<fptype>(
+        quadric, SIMD::loadPartial(x + j, width),
+        SIMD::loadPartial(y + j, width),
+        SIMD::loadPartial(z + j, width));
+    SIMD::storePartial(values + j, val, width);
+  }
+}
+
+#endif
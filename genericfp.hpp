@@ -3,6 +3,7 @@
 #define _GENFP_H_
 
 #include <cfloat>
+#include <climits>
 
 #include <assert.h>
 
@@ -18,12 +19,12 @@ struct fp {
                                   precision = p + 1;
   static constexpr const unsigned long minMantissa = 0;
   static constexpr const unsigned long maxMantissa =
-      (1 << p) - 1;
+      ~0ul >> (sizeof(unsigned long) * CHAR_BIT - p);
   static constexpr const unsigned long centralExp =
-      (1 << (e - 1)) - 1;
+      (1ul << (e - 1)) - 1;
   static constexpr const unsigned long zeroExp = 0;
   static constexpr const unsigned long infExp =
-      (1 << e) - 1;
+      (1ul << e) - 1;
 } __attribute__((packed));
 
 /* The bitfield lengths specified by IEEE 754 */
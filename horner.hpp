@@ -0,0 +1,178 @@
+
+#ifndef _HORNER_HPP_
+#define _HORNER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <assert.h>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "simd.hpp"
+
+/* Polynomial evaluation.
+ * Every polynomial is given by its degree + 1 coefficients,
+ * with coeffs[i] the coefficient of x^i
+ */
+
+template <typename fptype>
+fptype horner(const fptype *coeffs, unsigned degree,
+              fptype x) {
+  fptype r = coeffs[degree];
+  for(unsigned i = degree; i-- > 0;) r = r * x + coeffs[i];
+  return r;
+}
+
+template <typename fptype>
+fptype fmaHorner(const fptype *coeffs, unsigned degree,
+                 fptype x) {
+  fptype r = coeffs[degree];
+  for(unsigned i = degree; i-- > 0;)
+    r = std::fma(r, x, coeffs[i]);
+  return r;
+}
+
+/* Graillat, Langlois, and Louvet's CompHorner.
+ * The rounding errors of each product and sum of Horner's
+ * scheme are exact, and are the coefficients of two error
+ * polynomials, whose sum is evaluated alongside it.
+ * The result is as accurate as if it were computed with
+ * twice the precision and then rounded
+ */
+template <typename fptype>
+fptype compHorner(const fptype *coeffs, unsigned degree,
+                  fptype x) {
+  fptype s = coeffs[degree];
+  fptype c = 0.0;
+  for(unsigned i = degree; i-- > 0;) {
+    std::array<fptype, 2> prod = twoProd(s, x);
+    std::array<fptype, 2> sum = twoSum(prod[0], coeffs[i]);
+    s = sum[0];
+    c = c * x + (prod[1] + sum[1]);
+  }
+  return s + c;
+}
+
+/* CompHorner applied recursively to its error polynomials,
+ * which is as accurate as Horner's scheme computed with K
+ * times the precision and then rounded.
+ * Each level splits every polynomial into its value and
+ * two error polynomials of one lower degree, so level l
+ * has 2^l polynomials; the last level is evaluated with
+ * Horner's scheme.
+ * The values of every level are summed with iFastSum.
+ * K = 1 is Horner's scheme, and K = 2 is CompHorner
+ * with the error polynomials kept apart
+ */
+template <typename fptype>
+class KFoldHorner {
+ public:
+  KFoldHorner(unsigned K)
+      : K(K), current(), next(), partials() {
+    assert(K >= 1);
+  }
+
+  unsigned folds() const { return K; }
+
+  fptype evaluate(const fptype *coeffs, unsigned degree,
+                  fptype x) {
+    current.assign(coeffs, coeffs + degree + 1);
+    partials.clear();
+    unsigned count = 1;
+    for(unsigned level = 1; level < K && degree > 0;
+        level++) {
+      next.resize(2 * count * degree);
+      for(unsigned p = 0; p < count; p++) {
+        const fptype *poly =
+            current.data() + p * (degree + 1);
+        fptype *prodErrs = next.data() + 2 * p * degree;
+        fptype *sumErrs = prodErrs + degree;
+        fptype s = poly[degree];
+        for(unsigned i = degree; i-- > 0;) {
+          std::array<fptype, 2> prod = twoProd(s, x);
+          std::array<fptype, 2> sum =
+              twoSum(prod[0], poly[i]);
+          s = sum[0];
+          prodErrs[i] = prod[1];
+          sumErrs[i] = sum[1];
+        }
+        if(s != 0.0) partials.push_back(s);
+      }
+      current.swap(next);
+      count *= 2;
+      degree--;
+    }
+    for(unsigned p = 0; p < count; p++) {
+      fptype val = horner(
+          current.data() + p * (degree + 1), degree, x);
+      if(val != 0.0) partials.push_back(val);
+    }
+    return iFastSum(partials.data(), partials.size());
+  }
+
+ private:
+  const unsigned K;
+  std::vector<fptype> current;
+  std::vector<fptype> next;
+  std::vector<fptype> partials;
+};
+
+/* Evaluates the polynomial at count points, with a point
+ * per lane.
+ * Each lane computes exactly what the scalar version
+ * computes for its point
+ */
+template <typename fptype>
+void hornerSIMD(const fptype *coeffs, unsigned degree,
+                const fptype *points, fptype *results,
+                unsigned count) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    const vec x = SIMD::loadPartial(points + j, width);
+    vec r = vec{} + coeffs[degree];
+    for(unsigned i = degree; i-- > 0;)
+      r = r * x + coeffs[i];
+    SIMD::storePartial(results + j, r, width);
+  }
+}
+
+/* CompHorner with a point per lane.
+ * GCC's vector types have no FMA, so the products are
+ * split with Dekker's TwoProd, and the sums use Knuth's
+ * TwoSum; both are exact, so each lane computes exactly
+ * what compHorner computes for its point.
+ * The points and coefficients must be far enough from
+ * overflow that Veltkamp's splitting doesn't overflow
+ */
+template <typename fptype>
+void compHornerSIMD(const fptype *coeffs, unsigned degree,
+                    const fptype *points, fptype *results,
+                    unsigned count) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    const vec x = SIMD::loadPartial(points + j, width);
+    vec s = vec{} + coeffs[degree];
+    vec c = {};
+    for(unsigned i = degree; i-- > 0;) {
+      std::array<vec, 2> prod =
+          twoProdDekker<fptype>(s, x);
+      std::array<vec, 2> sum =
+          twoSumBranchFree(prod[0], vec{} + coeffs[i]);
+      s = sum[0];
+      c = c * x + (prod[1] + sum[1]);
+    }
+    vec r = s + c;
+    SIMD::storePartial(results + j, r, width);
+  }
+}
+
+#endif
@@ -0,0 +1,204 @@
+
+#ifndef _INTERVAL_HPP_
+#define _INTERVAL_HPP_
+
+#include <cfenv>
+#include <cmath>
+
+#include "simd.hpp"
+
+/* Interval arithmetic with directed rounding.
+ * An interval is stored as its negated lower bound and its
+ * upper bound, so rounding both bounds outward only needs
+ * rounding upward: the lower bound of a sum is
+ *   -((-a.lo) + (-b.lo)),
+ * with the inner sum rounded up.
+ * The operations are only valid while an UpwardRounding
+ * guard is alive, so a batch of intervals is computed with
+ * one mode switch, not one per operation.
+ * Code using these must be compiled with -frounding-math,
+ * so that the compiler doesn't move arithmetic across the
+ * mode switches.
+ * T is either fptype, or a vector of fptype, which holds
+ * an interval per lane with the bounds in separate
+ * registers
+ */
+
+/* Sets the rounding mode to upward for its lifetime */
+class UpwardRounding {
+ public:
+  UpwardRounding() : saved(std::fegetround()) {
+    std::fesetround(FE_UPWARD);
+  }
+  ~UpwardRounding() { std::fesetround(saved); }
+
+  UpwardRounding(const UpwardRounding &) = delete;
+  UpwardRounding &operator=(const UpwardRounding &) =
+      delete;
+
+ private:
+  const int saved;
+};
+
+template <typename fptype, typename T = fptype>
+class Interval {
+ public:
+  Interval() : negLo(), hi() {}
+  Interval(T val) : negLo(-val), hi(val) {}
+
+  static Interval fromBounds(T lo, T hi) {
+    Interval bounds;
+    bounds.negLo = -lo;
+    bounds.hi = hi;
+    return bounds;
+  }
+
+  T lower() const { return -negLo; }
+  T upper() const { return hi; }
+  /* Rounded up, so it's never an underestimate */
+  T width() const { return hi + negLo; }
+
+  Interval operator-() const {
+    Interval neg;
+    neg.negLo = hi;
+    neg.hi = negLo;
+    return neg;
+  }
+
+  Interval &operator+=(const Interval &rhs) {
+    negLo += rhs.negLo;
+    hi += rhs.hi;
+    return *this;
+  }
+
+  Interval &operator-=(const Interval &rhs) {
+    return *this += -rhs;
+  }
+
+  /* The bounds of the product are the extreme products of
+   * the bounds, so the upper bound is the largest of them
+   * rounded up, and the negated lower bound the largest of
+   * the negated products rounded up
+   */
+  Interval &operator*=(const Interval &rhs) {
+    const T lo = lower(), rhsLo = rhs.lower();
+    const T upper = max(max(hi * rhs.hi, lo * rhsLo),
+                        max(hi * rhsLo, lo * rhs.hi));
+    negLo = max(max(negLo * rhs.hi, negLo * rhsLo),
+                max(-hi * rhs.hi, -hi * rhsLo));
+    hi = upper;
+    return *this;
+  }
+
+  /* Like the product, with every bound product fused with
+   * c's bound
+   */
+  static Interval fma(const Interval &a, const Interval &b,
+                      const Interval &c) {
+    const T aLo = a.lower(), bLo = b.lower();
+    Interval result;
+    result.hi = max(max(fused(a.hi, b.hi, c.hi),
+                        fused(aLo, bLo, c.hi)),
+                    max(fused(a.hi, bLo, c.hi),
+                        fused(aLo, b.hi, c.hi)));
+    result.negLo =
+        max(max(fused(a.negLo, b.hi, c.negLo),
+                fused(a.negLo, bLo, c.negLo)),
+            max(fused(-a.hi, b.hi, c.negLo),
+                fused(-a.hi, bLo, c.negLo)));
+    return result;
+  }
+
+  /* The product of a point with a point, added to c,
+   * which needs one FMA per bound
+   */
+  static Interval fmaPoint(T a, T b, const Interval &c) {
+    Interval result;
+    result.hi = fused(a, b, c.hi);
+    result.negLo = fused(-a, b, c.negLo);
+    return result;
+  }
+
+  T negLo, hi;
+
+ private:
+  static T max(T lhs, T rhs) {
+    return lhs < rhs ? rhs : lhs;
+  }
+
+  static T fused(T a, T b, T c) {
+    return fusedImpl(a, b, c);
+  }
+
+  static fptype fusedImpl(fptype a, fptype b, fptype c) {
+    return std::fma(a, b, c);
+  }
+
+  template <typename vec>
+  static vec fusedImpl(vec a, vec b, vec c) {
+    return SIMD::fma<fptype>(a, b, c);
+  }
+};
+
+template <typename fptype, typename T>
+Interval<fptype, T> operator+(
+    Interval<fptype, T> lhs,
+    const Interval<fptype, T> &rhs) {
+  return lhs += rhs;
+}
+
+template <typename fptype, typename T>
+Interval<fptype, T> operator-(
+    Interval<fptype, T> lhs,
+    const Interval<fptype, T> &rhs) {
+  return lhs -= rhs;
+}
+
+template <typename fptype, typename T>
+Interval<fptype, T> operator*(
+    Interval<fptype, T> lhs,
+    const Interval<fptype, T> &rhs) {
+  return lhs *= rhs;
+}
+
+/* 1 or -1 when every value in the interval has that sign,
+ * or 0 when the sign isn't certain
+ */
+template <typename fptype>
+int certifiedSign(const Interval<fptype> &val) {
+  if(val.lower() > 0) return 1;
+  if(val.upper() < 0) return -1;
+  return 0;
+}
+
+/* Encloses the dot product of vec1 and vec2, with a vector
+ * of intervals accumulating a lane each.
+ * Every product is of two points, so each bound needs one
+ * FMA
+ */
+template <typename fptype>
+Interval<fptype> intervalDotProd(const fptype *vec1,
+                                 const fptype *vec2,
+                                 unsigned dim) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  Interval<fptype, vec> sum;
+  unsigned i = 0;
+  for(; i + lanes <= dim; i += lanes) {
+    sum = Interval<fptype, vec>::fmaPoint(
+        SIMD::load(vec1 + i), SIMD::load(vec2 + i), sum);
+  }
+  Interval<fptype> result;
+  for(unsigned j = 0; j < lanes; j++) {
+    result.negLo += sum.negLo[j];
+    result.hi += sum.hi[j];
+  }
+  for(; i < dim; i++) {
+    result = Interval<fptype>::fmaPoint(vec1[i], vec2[i],
+                                        result);
+  }
+  return result;
+}
+
+#endif
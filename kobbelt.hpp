@@ -62,15 +62,21 @@ void tableInsert(std::map<int, fptype> &table, fptype val) {
   }
 }
 
-template <typename fptype, typename rettype>
-rettype kobbeltDotProd(const fptype *v1, const fptype *v2,
+/* The inputs are converted to fptype before their exact
+ * products are formed, so fptype must be at least as
+ * precise as intype
+ */
+template <typename fptype, typename rettype,
+          typename intype>
+rettype kobbeltDotProd(const intype *v1, const intype *v2,
                        const unsigned int size) {
   /* Start by inserting the exact products
    * of the values into a table ordered by their genus
    */
   std::map<int, fptype> table;
   for(unsigned int i = 0; i < size; i++) {
-    std::array<fptype, 2> prod = twoProd(v1[i], v2[i]);
+    std::array<fptype, 2> prod =
+        twoProd(fptype(v1[i]), fptype(v2[i]));
     tableInsert(table, prod[0]);
     tableInsert(table, prod[1]);
   }
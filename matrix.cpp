@@ -0,0 +1,337 @@
+
+#include "numerictester.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+#include "gemm.hpp"
+#include "ozaki.hpp"
+
+#include <algorithm>
+#include <random>
+#include <typeinfo>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+#include <assert.h>
+#include <time.h>
+
+/* The precision of the statistics; the references use
+ * MatrixCase::referencePrecision
+ */
+constexpr const unsigned statBits = 256;
+
+/* A is rows x inner and B is inner x cols, both row major;
+ * GEMV cases have cols = 1.
+ * Each entry of the product has its own MPFR reference,
+ * and is added to the statistics separately
+ */
+template <typename fptype>
+class MatrixCase : public NumericTester::TestCase {
+ public:
+  MatrixCase(std::mt19937_64 &rgen,
+             std::uniform_real_distribution<fptype> &dist,
+             unsigned rows, unsigned cols, unsigned inner)
+      : NumericTester::TestCase(),
+        a(rows * inner),
+        b(inner * cols),
+        correctEntries(rows * cols),
+        rows(rows),
+        cols(cols),
+        inner(inner) {
+    for(auto &val : a) val = dist(rgen);
+    for(auto &val : b) val = dist(rgen);
+    const mpfr_prec_t prec = referencePrecision();
+    beginExactReference();
+    for(unsigned i = 0; i < rows; i++) {
+      for(unsigned j = 0; j < cols; j++) {
+        mpfr::mpreal accumulator(0.0, prec);
+        for(unsigned k = 0; k < inner; k++) {
+          mpfr::mpreal prod(a[i * inner + k], prec);
+          prod *= b[k * cols + j];
+          accumulator += prod;
+        }
+        correctEntries[i * cols + j] = accumulator;
+      }
+    }
+    endExactReference();
+    correct = correctEntries[0];
+  }
+
+  std::vector<fptype> a;
+  std::vector<fptype> b;
+  std::vector<mpfr::mpreal> correctEntries;
+  const unsigned rows, cols, inner;
+
+ private:
+  /* The least precision which holds every entry exactly,
+   * from the exponents of A and B; an entry sums inner
+   * products of 2 factors
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    for(const std::vector<fptype> *m : {&a, &b}) {
+      for(fptype val : *m) {
+        if(val == 0) continue;
+        const int exp = std::ilogb(val) + 1;
+        ulpExp = std::min(
+            ulpExp,
+            NumericTester::ulpExponent<fptype>(exp));
+        maxExp = std::max<long>(maxExp, exp);
+      }
+    }
+    return NumericTester::exactPrecision(ulpExp, maxExp, 2,
+                                         inner);
+  }
+};
+
+/* Use the Curiously Recurring Template Pattern (CRTP)
+ * to implement static polymorphism here.
+ * Throughput is reported as GFLOP/s, counting a multiply
+ * and an add per term of each entry
+ */
+template <typename fptype, typename derived>
+class MatTestInterface : public NumericTester::NumericTest {
+ public:
+  MatTestInterface()
+      : NumericTester::NumericTest(),
+        result(),
+        flops(0.0) {}
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const MatrixCase<fptype>));
+    const MatrixCase<fptype> *matCase =
+        static_cast<const MatrixCase<fptype> *>(&testCase);
+    result.resize(matCase->rows * matCase->cols);
+    startTimer();
+    static_cast<derived *>(this)->runTest(matCase,
+                                          result.data());
+    stopTimer();
+    flops += 2.0 * matCase->rows * matCase->cols *
+             matCase->inner;
+    for(unsigned e = 0; e < result.size(); e++) {
+      mpfr::mpreal estimate(result[e]);
+      addStatistic(estimate, matCase->correctEntries[e]);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "GFLOP/s: " << flops / seconds / 1e9 << "\n";
+  }
+
+ protected:
+  static std::string precisionName() {
+    return GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  std::vector<fptype> result;
+  double flops;
+};
+
+template <typename fptype>
+class MatNaiveGEMVTest
+    : public MatTestInterface<fptype,
+                              MatNaiveGEMVTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Naive GEMV with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    assert(matCase->cols == 1);
+    naiveGEMV(matCase->a.data(), matCase->b.data(), result,
+              matCase->rows, matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatBlockedGEMVTest
+    : public MatTestInterface<fptype,
+                              MatBlockedGEMVTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Blocked GEMV with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    assert(matCase->cols == 1);
+    blockedGEMV(matCase->a.data(), matCase->b.data(),
+                result, matCase->rows, matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatCompensatedGEMVTest
+    : public MatTestInterface<
+          fptype, MatCompensatedGEMVTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Compensated GEMV with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    assert(matCase->cols == 1);
+    compensatedGEMV(matCase->a.data(), matCase->b.data(),
+                    result, matCase->rows, matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatNaiveGEMMTest
+    : public MatTestInterface<fptype,
+                              MatNaiveGEMMTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Naive GEMM with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    naiveGEMM(matCase->a.data(), matCase->b.data(), result,
+              matCase->rows, matCase->cols, matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatBlockedGEMMTest
+    : public MatTestInterface<fptype,
+                              MatBlockedGEMMTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Blocked GEMM with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    blockedGEMM(matCase->a.data(), matCase->b.data(),
+                result, matCase->rows, matCase->cols,
+                matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatCompensatedGEMMTest
+    : public MatTestInterface<
+          fptype, MatCompensatedGEMMTest<fptype>> {
+ public:
+  virtual std::string testName() {
+    return std::string("Compensated Blocked GEMM with ") +
+           this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    compensatedGEMM(matCase->a.data(), matCase->b.data(),
+                    result, matCase->rows, matCase->cols,
+                    matCase->inner);
+  }
+};
+
+template <typename fptype>
+class MatOzakiGEMMTest
+    : public MatTestInterface<fptype,
+                              MatOzakiGEMMTest<fptype>> {
+ public:
+  MatOzakiGEMMTest(unsigned numSlices) : ozaki(numSlices) {}
+
+  virtual std::string testName() {
+    return std::string("Ozaki ") +
+           std::to_string(ozaki.slices()) +
+           " Slice GEMM with " + this->precisionName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const MatrixCase<fptype> *matCase,
+          fptype *result) {
+    ozaki.gemm(matCase->a.data(), matCase->b.data(), result,
+               matCase->rows, matCase->cols,
+               matCase->inner);
+  }
+
+ private:
+  OzakiScheme<fptype> ozaki;
+};
+
+template <typename fptype, unsigned numMatTests>
+void runTests(
+    std::mt19937_64 &engine,
+    NumericTester::NumericTest *(&tests)[numMatTests],
+    const int numTests, const unsigned rows,
+    const unsigned cols, const unsigned inner) {
+  std::uniform_real_distribution<fptype> rgenf(-1.0, 1.0);
+  for(int i = 0; i < numTests; i++) {
+    MatrixCase<fptype> testcase(engine, rgenf, rows, cols,
+                                inner);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+template <typename fptype>
+void runTests(std::mt19937_64 &engine, const int numTests,
+              const unsigned size) {
+  NumericTester::NumericTest *gemvTests[] = {
+      new MatNaiveGEMVTest<fptype>(),
+      new MatBlockedGEMVTest<fptype>(),
+      new MatCompensatedGEMVTest<fptype>()};
+  runTests<fptype>(engine, gemvTests, numTests, size, 1,
+                   size);
+  NumericTester::NumericTest *gemmTests[] = {
+      new MatNaiveGEMMTest<fptype>(),
+      new MatBlockedGEMMTest<fptype>(),
+      new MatCompensatedGEMMTest<fptype>(),
+      new MatOzakiGEMMTest<fptype>(2)};
+  runTests<fptype>(engine, gemmTests, numTests, size, size,
+                   size);
+}
+
+int main(int argc, char **argv) {
+  int numTests = 32;
+  int size = 64;
+  if(argc > 1) {
+    numTests = atoi(argv[1]);
+    if(numTests < 1) {
+      printf("Number of tests must be greater than 0\n");
+      return -1;
+    }
+    if(argc > 2) {
+      size = atoi(argv[2]);
+      if(size < 1) {
+        printf("Matrix size must be greater than 0\n");
+        return -1;
+      }
+    }
+  }
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  runTests<float>(engine, numTests, size);
+  runTests<double>(engine, numTests, size);
+  return 0;
+}
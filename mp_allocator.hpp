@@ -0,0 +1,214 @@
+#ifndef _MP_ALLOCATOR_HPP_
+#define _MP_ALLOCATOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <gmp.h>
+
+/* A pool allocator for the limbs of MPFR values, installed
+ * as GMP's memory functions, which MPFR allocates with.
+ * Blocks up to maxPooled bytes are rounded up to a size
+ * class and carved from slabs; freed blocks go onto the
+ * freeing thread's list for their class, so a temporary
+ * of the working precision costs a few loads and stores.
+ * Every block starts with a header holding its class and
+ * slab, as MPFR doesn't always free strings with the size
+ * they were allocated with.
+ * Blocks may be freed by a thread other than the one which
+ * allocated them, so slabs count the blocks carved from
+ * them; a thread's pool releases the blocks on its lists
+ * when the thread exits, and a slab is freed with its last
+ * block.
+ * Like GMP's default functions, these abort when memory
+ * runs out, since GMP and MPFR can't unwind an exception.
+ * install must be called before any GMP or MPFR value is
+ * allocated, as blocks from the previous allocator can't
+ * be freed by this one
+ */
+namespace MPAllocator {
+
+constexpr const size_t granularity = 16;
+constexpr const size_t headerSize = granularity;
+constexpr const size_t maxPooled = 1024;
+constexpr const size_t numClasses = maxPooled / granularity;
+constexpr const size_t slabSize = 64 << 10;
+/* The class recorded for blocks from malloc */
+constexpr const size_t largeClass = numClasses;
+
+/* The unreleased blocks carved from the slab, and one more
+ * while it's a pool's current slab
+ */
+struct Slab {
+  std::atomic<size_t> refs;
+};
+
+constexpr const size_t slabHeaderSize = granularity;
+static_assert(sizeof(Slab) <= slabHeaderSize,
+              "The slab header must fit before its blocks");
+
+struct Header {
+  size_t cls;
+  Slab *slab;
+};
+
+static_assert(sizeof(Header) <= headerSize,
+              "The block header must fit before the block");
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+/* The number of slabs which haven't been freed */
+inline std::atomic<size_t> &numSlabs() {
+  static std::atomic<size_t> count(0);
+  return count;
+}
+
+inline void outOfMemory(size_t bytes) {
+  std::fprintf(stderr,
+               "MPAllocator: Cannot allocate memory "
+               "(size=%zu)\n",
+               bytes);
+  std::abort();
+}
+
+inline void release(Slab *slab) {
+  if(slab->refs.fetch_sub(1, std::memory_order_acq_rel) ==
+     1) {
+    slab->~Slab();
+    std::free(slab);
+    numSlabs().fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+inline Header &blockHeader(void *ptr) {
+  return *reinterpret_cast<Header *>(
+      static_cast<char *>(ptr) - headerSize);
+}
+
+/* Set once the thread's pool is destroyed; blocks freed
+ * after that, as by other thread local destructors, are
+ * released at once
+ */
+inline bool &poolDestroyed() {
+  static thread_local bool destroyed = false;
+  return destroyed;
+}
+
+/* Zero initialized, so the pool only needs a destructor
+ * per thread
+ */
+struct Pool {
+  ~Pool() {
+    for(size_t cls = 0; cls < numClasses; cls++) {
+      while(freeLists[cls] != NULL) {
+        FreeBlock *block = freeLists[cls];
+        freeLists[cls] = block->next;
+        release(blockHeader(block).slab);
+      }
+    }
+    if(current != NULL) release(current);
+    poolDestroyed() = true;
+  }
+
+  FreeBlock *freeLists[numClasses];
+  Slab *current;
+  char *slab;
+  size_t slabLeft;
+};
+
+inline Pool &threadPool() {
+  static thread_local Pool pool = {};
+  return pool;
+}
+
+inline size_t sizeClass(size_t bytes) {
+  if(bytes == 0 || bytes > maxPooled) return largeClass;
+  return (bytes - 1) / granularity;
+}
+
+inline void *allocate(size_t bytes) {
+  size_t cls = sizeClass(bytes);
+  if(poolDestroyed()) cls = largeClass;
+  char *block;
+  Slab *owner = NULL;
+  if(cls == largeClass) {
+    block = static_cast<char *>(
+        std::malloc(headerSize + bytes));
+    if(block == NULL) outOfMemory(bytes);
+  } else {
+    Pool &pool = threadPool();
+    FreeBlock *head = pool.freeLists[cls];
+    if(head != NULL) {
+      pool.freeLists[cls] = head->next;
+      return head;
+    }
+    const size_t blockSize =
+        headerSize + (cls + 1) * granularity;
+    if(pool.slabLeft < blockSize) {
+      char *fresh =
+          static_cast<char *>(std::malloc(slabSize));
+      if(fresh == NULL) outOfMemory(slabSize);
+      numSlabs().fetch_add(1, std::memory_order_relaxed);
+      if(pool.current != NULL) release(pool.current);
+      pool.current = new(fresh) Slab{{1}};
+      pool.slab = fresh + slabHeaderSize;
+      pool.slabLeft = slabSize - slabHeaderSize;
+    }
+    block = pool.slab;
+    pool.slab += blockSize;
+    pool.slabLeft -= blockSize;
+    owner = pool.current;
+    owner->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  *reinterpret_cast<Header *>(block) = {cls, owner};
+  return block + headerSize;
+}
+
+inline size_t blockClass(void *ptr) {
+  return blockHeader(ptr).cls;
+}
+
+/* The size GMP passes is ignored, the header is used */
+inline void deallocate(void *ptr, size_t) {
+  const Header &header = blockHeader(ptr);
+  if(header.cls == largeClass) {
+    std::free(static_cast<char *>(ptr) - headerSize);
+    return;
+  }
+  if(poolDestroyed()) {
+    release(header.slab);
+    return;
+  }
+  Pool &pool = threadPool();
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  block->next = pool.freeLists[header.cls];
+  pool.freeLists[header.cls] = block;
+}
+
+inline void *reallocate(void *ptr, size_t oldBytes,
+                        size_t newBytes) {
+  const size_t cls = blockClass(ptr);
+  if(cls != largeClass && cls == sizeClass(newBytes))
+    return ptr;
+  size_t used = std::min(oldBytes, newBytes);
+  if(cls != largeClass)
+    used = std::min(used, (cls + 1) * granularity);
+  void *moved = allocate(newBytes);
+  std::memcpy(moved, ptr, used);
+  deallocate(ptr, oldBytes);
+  return moved;
+}
+
+inline void install() {
+  mp_set_memory_functions(allocate, reallocate, deallocate);
+}
+}
+
+#endif
@@ -1,11 +1,25 @@
 
 #include "numerictester.hpp"
+#include "mp_allocator.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <assert.h>
 
 namespace NumericTester {
 
+/* Every tool links this file, and none creates MPFR values
+ * during static initialization, so the allocator is in
+ * place before the first one
+ */
+static const bool mpAllocatorInstalled =
+    (MPAllocator::install(), true);
+
+void NumericTest::updateStatsBatch(const CaseBlock &block) {
+  for(unsigned i = 0; i < block.size(); i++)
+    updateStats(block[i]);
+}
+
 struct timespec NumericTest::totalRunTime() const {
   return runningTime;
 };
@@ -50,7 +64,10 @@ NumericTest::calcRelErrorPercentile(double frac) {
       (int)std::floor((1.0 - frac) * relErrors.size());
   assert(botPos >= 0);
   assert(botPos < (int)relErrors.size());
-  int topPos = (int)std::ceil(frac * relErrors.size());
+  /* Small samples round up past the last element */
+  int topPos = std::min(
+      (int)std::ceil(frac * relErrors.size()),
+      (int)relErrors.size() - 1);
   assert(topPos >= 0);
   assert(topPos < (int)relErrors.size());
   std::array<mpfr::mpreal, 2> ret;
@@ -97,32 +114,93 @@ void NumericTest::addTime(struct timespec len) {
   }
 }
 
-void NumericTest::addStatistic(mpfr::mpreal estimate,
-                               mpfr::mpreal correct) {
-  mpfr::mpreal absErr = abs(estimate - correct);
-  absErrors.push_back(absErr);
-  mpfr::mpreal relErr = abs(absErr / correct);
-  relErrors.push_back(relErr);
+/* The errors are computed in place and moved into the
+ * vectors, so only they are allocated
+ */
+void NumericTest::addStatistic(
+    const mpfr::mpreal &estimate,
+    const mpfr::mpreal &correct) {
+  mpfr::mpreal absErr = estimate - correct;
+  mpfr_abs(absErr.mpfr_ptr(), absErr.mpfr_srcptr(),
+           MPFR_RNDN);
+  mpfr::mpreal relErr(absErr);
+  relErr /= correct;
+  mpfr_abs(relErr.mpfr_ptr(), relErr.mpfr_srcptr(),
+           MPFR_RNDN);
   accumRelErr += relErr;
   if(isnan(maxRelErr) || relErr > maxRelErr)
     maxRelErr = relErr;
   if(isnan(minRelErr) || relErr < minRelErr)
     minRelErr = relErr;
+  absErrors.push_back(std::move(absErr));
+  relErrors.push_back(std::move(relErr));
+}
+
+void NumericTest::addSignStatistic(
+    const mpfr::mpreal &estimate,
+    const mpfr::mpreal &correct,
+    const mpfr::mpreal &distance) {
+  signTests++;
+  const int correctSign = mpfr::sgn(correct);
+  if(!isnan(estimate) && mpfr::sgn(estimate) == correctSign)
+    return;
+  if(isnan(estimate) || (correctSign != 0 &&
+                         !mpfr::iszero(estimate)))
+    wrongSigns++;
+  else if(correctSign == 0)
+    zerosAsNonzero++;
+  else
+    nonzerosAsZero++;
+  int bin = 0;
+  if(!mpfr::iszero(distance)) {
+    /* distance is in [2^(exp - 1), 2^exp) */
+    const long exp = mpfr_get_exp(distance.mpfr_srcptr()) -
+                     1 - minSignExp;
+    bin = std::max(
+        0L, std::min(exp, (long)numSignBins - 1));
+  }
+  misclassified[bin]++;
+}
+
+void NumericTest::printSignStats(std::ostream &out) {
+  out << "Sign Tests: " << signTests << "\n"
+      << "Wrong Signs: " << wrongSigns << "\n"
+      << "Zeros Classified as Nonzero: " << zerosAsNonzero
+      << "\n"
+      << "Nonzeros Classified as Zero: " << nonzerosAsZero
+      << "\n";
+  for(unsigned i = 0; i < numSignBins; i++) {
+    if(misclassified[i] == 0) continue;
+    out << "Misclassified at Distance 2^"
+        << (int)i + minSignExp << ": " << misclassified[i]
+        << "\n";
+  }
 }
 
 void NumericTest::dumpData(std::ostream &out) {
   printStats(out);
-  out << "Absolute Error, Relative Error\n";
-  for(unsigned i = 0; i < relErrors.size(); i++) {
-    mpfr::mpreal absErr = absErrors[i];
-    out << absErr << ", ";
-    mpfr::mpreal relErr = relErrors[i];
-    out << relErr << "\n";
+  if(signMode) {
+    out << "Distance Exponent, Misclassifications\n";
+    for(unsigned i = 0; i < numSignBins; i++)
+      out << (int)i + minSignExp << ", "
+          << misclassified[i] << "\n";
+    return;
   }
+  out << "Absolute Error, Relative Error\n";
+  for(unsigned i = 0; i < relErrors.size(); i++)
+    out << absErrors[i] << ", " << relErrors[i] << "\n";
 }
 
 void NumericTest::printStats(std::ostream &out) {
   constexpr const int nsDigits = 9;
+  if(signMode) {
+    out << testName() << "\n"
+        << "Running Time: " << runningTime.tv_sec << "."
+        << std::setw(nsDigits) << std::setfill('0')
+        << runningTime.tv_nsec << "\n";
+    printSignStats(out);
+    return;
+  }
   std::array<mpfr::mpreal, 2> percent =
       calcRelErrorPercentile(0.99);
   out << testName() << "\n"
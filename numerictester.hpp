@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <limits>
 
 #include <iostream>
 #include <time.h>
@@ -15,6 +17,32 @@
 
 namespace NumericTester {
 
+/* The exponent of the smallest ulp of the fptype values
+ * with binary exponents of at least minExp, as returned by
+ * frexp; subnormals have the ulp of the smallest normal
+ */
+template <typename fptype>
+long ulpExponent(int minExp) {
+  using limits = std::numeric_limits<fptype>;
+  return std::max(minExp, limits::min_exponent) -
+         limits::digits;
+}
+
+/* The precision which represents every sum of numTerms
+ * products of factors values exactly, when each value is a
+ * multiple of 2^ulpExp and smaller than 2^maxExp in
+ * magnitude
+ */
+inline mpfr_prec_t exactPrecision(long ulpExp, long maxExp,
+                                  unsigned factors,
+                                  unsigned long numTerms) {
+  long sumBits = 0;
+  while((1ul << sumBits) < numTerms) sumBits++;
+  const long bits =
+      factors * (maxExp - ulpExp) + sumBits;
+  return std::max<long>(bits, MPFR_PREC_MIN);
+}
+
 class TestCase {
  public:
   TestCase() : correct() {}
@@ -23,14 +51,50 @@ class TestCase {
     return correct;
   }
 
+  class InexactReferenceError {};
+
  protected:
+  /* Check with MPFR's inexact flag that the correct value
+   * computed between these calls was exact; if anything
+   * was rounded, an InexactReferenceError is thrown
+   */
+  static void beginExactReference() {
+    mpfr_clear_inexflag();
+  }
+  static void endExactReference() {
+    if(mpfr_inexflag_p()) throw InexactReferenceError();
+  }
+
   mpfr::mpreal correct;
 };
 
+/* A block of test cases, which tests can process with one
+ * call to updateStatsBatch.
+ * Blocks are expected to store their cases' data
+ * contiguously, so a test can stream through them
+ */
+class CaseBlock {
+ public:
+  virtual ~CaseBlock() {}
+  virtual unsigned size() const = 0;
+  virtual const TestCase &operator[](unsigned i) const = 0;
+};
+
 class NumericTest {
  public:
-  NumericTest()
-      : runningTime({0, 0}),
+  /* In sign mode, only the signs of the estimates are
+   * checked, with addSignStatistic, and the statistics are
+   * counts which take O(1) memory
+   */
+  NumericTest(bool signMode = false)
+      : signMode(signMode),
+        wrongSigns(0),
+        zerosAsNonzero(0),
+        nonzerosAsZero(0),
+        signTests(0),
+        misclassified(),
+        timerClock(CLOCK_PROCESS_CPUTIME_ID),
+        runningTime({0, 0}),
         startTime({0, 0}),
         endTime({0, 0}),
         absErrors(),
@@ -42,6 +106,12 @@ class NumericTest {
   virtual ~NumericTest(){};
 
   virtual void updateStats(const TestCase &) = 0;
+  /* Updates the statistics with every case of the block,
+   * in order.
+   * By default this calls updateStats for each case;
+   * tests override it to time the whole block at once
+   */
+  virtual void updateStatsBatch(const CaseBlock &block);
 
   virtual struct timespec totalRunTime() const;
 
@@ -77,12 +147,19 @@ class NumericTest {
       throw NoElementsError();
     mpfr::mpreal accumulator;
     accumulator = 0;
+    /* The average and scratch values are reused, so the
+     * loop doesn't allocate
+     */
+    const mpfr::mpreal avg = calcRelErrorAvg();
+    mpfr::mpreal delta, power;
     for(auto &err : relErrors) {
-      mpfr::mpreal delta = err - calcRelErrorAvg();
-      mpfr::mpreal power = delta;
       if(moment == 0) {
         if(err > 0) accumulator += 1;
       } else {
+        mpfr_sub(delta.mpfr_ptr(), err.mpfr_srcptr(),
+                 avg.mpfr_srcptr(), MPFR_RNDN);
+        mpfr_set(power.mpfr_ptr(), delta.mpfr_srcptr(),
+                 MPFR_RNDN);
         for(unsigned i = 1; i < moment; i++) power *= delta;
         accumulator += power;
       }
@@ -95,6 +172,36 @@ class NumericTest {
     return result;
   }
 
+  /* Misclassifications are binned by the binary exponent
+   * of the distance to the surface, from 2^minSignExp;
+   * the first and last bins also hold everything below and
+   * above them
+   */
+  static constexpr const int minSignExp = -64;
+  static constexpr const unsigned numSignBins = 96;
+
+  bool isSignMode() const { return signMode; }
+  unsigned long wrongSignCount() const {
+    return wrongSigns;
+  }
+  unsigned long zeroAsNonzeroCount() const {
+    return zerosAsNonzero;
+  }
+  unsigned long nonzeroAsZeroCount() const {
+    return nonzerosAsZero;
+  }
+  const std::array<unsigned long, numSignBins>
+      &misclassifiedByDistance() const {
+    return misclassified;
+  }
+
+  /* The timer measures the process' CPU time by default,
+   * which sums the time of every thread; tests which run
+   * on several threads, and the tests they're compared
+   * with, measure the elapsed time instead
+   */
+  void useWallClock() { timerClock = CLOCK_MONOTONIC; }
+
   class TimerError {};
   class NoElementsError {};
   class BadPercentileError {};
@@ -104,27 +211,40 @@ class NumericTest {
    * don't waste time on function calls
    */
   void startTimer() {
-    int err =
-        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &startTime);
+    int err = clock_gettime(timerClock, &startTime);
     assert(err == 0);
   }
   __attribute__((always_inline));
 
   void stopTimer() {
-    int err =
-        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &endTime);
+    int err = clock_gettime(timerClock, &endTime);
     assert(err == 0);
     struct timespec elapsed = calcDeltaTime();
     addTime(elapsed);
   }
   __attribute__((always_inline));
 
-  void addStatistic(mpfr::mpreal estimate,
-                    mpfr::mpreal correct);
+  void addStatistic(const mpfr::mpreal &estimate,
+                    const mpfr::mpreal &correct);
+  /* Checks the sign of the estimate, where the correct
+   * value is distance away from the surface where it's 0.
+   * A NaN estimate has the wrong sign
+   */
+  void addSignStatistic(const mpfr::mpreal &estimate,
+                        const mpfr::mpreal &correct,
+                        const mpfr::mpreal &distance);
+
+  virtual void printSignStats(std::ostream &out);
 
   struct timespec calcDeltaTime();
   void addTime(struct timespec len);
 
+  const bool signMode;
+  unsigned long wrongSigns, zerosAsNonzero, nonzerosAsZero;
+  unsigned long signTests;
+  std::array<unsigned long, numSignBins> misclassified;
+
+  clockid_t timerClock;
   struct timespec runningTime;
   struct timespec startTime, endTime;
   std::vector<mpfr::mpreal> absErrors;
@@ -0,0 +1,208 @@
+
+#ifndef _OZAKI_HPP_
+#define _OZAKI_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "genericfp.hpp"
+#include "simd.hpp"
+
+/* Ozaki, Ogita, Oishi, and Rump's error free splitting
+ * for dot products and matrix products.
+ * Each row is split into numSlices slices with the same
+ * extraction as extractVector.
+ * Every slice but the last has few enough bits that the
+ * dot product of any two of them is exact in fptype,
+ * whatever order it is summed in, so those pairs use a
+ * plain SIMD kernel.
+ * The last slice holds the remainder, and pairs with it
+ * use compensatedDotProd.
+ * Every pair of slices is formed: truncating to the pairs
+ * with s + t < numSlices assumes each element is near its
+ * row's maximum, while the dominant products of vectors
+ * with widely varying magnitudes can come from any pair.
+ * The pair results are summed with iFastSum.
+ * fptype must be float or double, and the inputs must be
+ * far enough from underflow that the slices' products
+ * don't underflow
+ */
+template <typename fptype>
+class OzakiScheme {
+ public:
+  OzakiScheme(unsigned numSlices)
+      : numSlices(numSlices),
+        slices1(),
+        slices2(),
+        transposed(),
+        pairResults(),
+        scratch() {
+    assert(numSlices >= 1);
+  }
+
+  unsigned slices() const { return numSlices; }
+
+  fptype dotProd(const fptype *vec1, const fptype *vec2,
+                 unsigned dim) {
+    if(dim == 0) return 0.0;
+    split(vec1, 1, dim, slices1);
+    split(vec2, 1, dim, slices2);
+    scratch.clear();
+    for(unsigned s = 0; s < numSlices; s++) {
+      for(unsigned t = 0; t < numSlices; t++) {
+        fptype pair =
+            pairDotProd(s, t, slices1.data() + s * dim,
+                        slices2.data() + t * dim, dim);
+        if(pair != 0.0) scratch.push_back(pair);
+      }
+    }
+    return iFastSum(scratch.data(), scratch.size());
+  }
+
+  /* C = A B, with A rows x inner, B inner x cols,
+   * and all three stored row major.
+   * B is transposed so both operands are split by rows,
+   * and C is computed in blockSize x blockSize tiles,
+   * so the rows of a tile stay in cache across the pairs
+   */
+  void gemm(const fptype *a, const fptype *b, fptype *c,
+            unsigned rows, unsigned cols, unsigned inner,
+            unsigned blockSize = 32) {
+    if(inner == 0) {
+      std::fill(c, c + rows * cols, fptype(0.0));
+      return;
+    }
+    transposed.resize(inner * cols);
+    for(unsigned k = 0; k < inner; k++) {
+      for(unsigned j = 0; j < cols; j++)
+        transposed[j * inner + k] = b[k * cols + j];
+    }
+    split(a, rows, inner, slices1);
+    split(transposed.data(), cols, inner, slices2);
+    const unsigned numPairs = numSlices * numSlices;
+    pairResults.resize(numPairs * rows * cols);
+    for(unsigned ib = 0; ib < rows; ib += blockSize) {
+      const unsigned iEnd = std::min(ib + blockSize, rows);
+      for(unsigned jb = 0; jb < cols; jb += blockSize) {
+        const unsigned jEnd =
+            std::min(jb + blockSize, cols);
+        unsigned pair = 0;
+        for(unsigned s = 0; s < numSlices; s++) {
+          for(unsigned t = 0; t < numSlices; t++) {
+            fptype *results =
+                pairResults.data() + pair * rows * cols;
+            for(unsigned i = ib; i < iEnd; i++) {
+              const fptype *row =
+                  slices1.data() + (s * rows + i) * inner;
+              for(unsigned j = jb; j < jEnd; j++) {
+                const fptype *col =
+                    slices2.data() + (t * cols + j) * inner;
+                results[i * cols + j] =
+                    pairDotProd(s, t, row, col, inner);
+              }
+            }
+            pair++;
+          }
+        }
+      }
+    }
+    for(unsigned e = 0; e < rows * cols; e++) {
+      scratch.clear();
+      for(unsigned p = 0; p < numPairs; p++) {
+        fptype val = pairResults[p * rows * cols + e];
+        if(val != 0.0) scratch.push_back(val);
+      }
+      c[e] = iFastSum(scratch.data(), scratch.size());
+    }
+  }
+
+ private:
+  /* Splits each of the rows into numSlices slices,
+   * stored so that slice s of row r starts at
+   * (s * numRows + r) * dim
+   */
+  void split(const fptype *src, unsigned numRows,
+             unsigned dim, std::vector<fptype> &dest) {
+    constexpr const int precision =
+        GenericFP::fpconvert<fptype>::precision;
+    /* Products of two slices have at most 2 * sliceBits
+     * bits, so a sum of dim of them is exact
+     */
+    int logDim = 0;
+    while((1ul << logDim) < dim) logDim++;
+    const int sliceBits = (precision - logDim) / 2;
+    dest.resize(numSlices * numRows * dim);
+    for(unsigned r = 0; r < numRows; r++) {
+      fptype *remainder =
+          dest.data() +
+          ((numSlices - 1) * numRows + r) * dim;
+      std::copy(src + r * dim, src + (r + 1) * dim,
+                remainder);
+      for(unsigned s = 0; s + 1 < numSlices; s++) {
+        fptype *slice =
+            dest.data() + (s * numRows + r) * dim;
+        fptype mu = 0.0;
+        for(unsigned i = 0; i < dim; i++)
+          mu = std::fmax(mu, std::fabs(remainder[i]));
+        if(mu == 0.0) {
+          std::fill(slice, slice + dim, fptype(0.0));
+          continue;
+        }
+        /* Rounds to multiples of 2^(exp - sliceBits),
+         * where |remainder| < 2^exp
+         */
+        int exp;
+        std::frexp(mu, &exp);
+        const fptype sigma =
+            fptype(1.5) *
+            std::ldexp(fptype(1.0),
+                       exp - sliceBits + precision - 1);
+        for(unsigned i = 0; i < dim; i++) {
+          fptype q = (sigma + remainder[i]) - sigma;
+          slice[i] = q;
+          remainder[i] -= q;
+        }
+      }
+    }
+  }
+
+  fptype pairDotProd(unsigned s, unsigned t,
+                     const fptype *vec1, const fptype *vec2,
+                     unsigned dim) const {
+    if(s + 1 == numSlices || t + 1 == numSlices)
+      return compensatedDotProd(vec1, vec2, dim);
+    return exactDotProd(vec1, vec2, dim);
+  }
+
+  /* Only exact for a pair of slices,
+   * so the lanes may be summed in any order
+   */
+  static fptype exactDotProd(const fptype *vec1,
+                             const fptype *vec2,
+                             unsigned dim) {
+    using vec = typename SIMD::Vector<fptype>::type;
+    constexpr const unsigned lanes =
+        SIMD::Vector<fptype>::lanes;
+    vec sum = {};
+    unsigned i = 0;
+    for(; i + lanes <= dim; i += lanes)
+      sum += SIMD::load(vec1 + i) * SIMD::load(vec2 + i);
+    sum += SIMD::loadPartial(vec1 + i, dim - i) *
+           SIMD::loadPartial(vec2 + i, dim - i);
+    fptype ret = 0.0;
+    for(unsigned j = 0; j < lanes; j++) ret += sum[j];
+    return ret;
+  }
+
+  const unsigned numSlices;
+  std::vector<fptype> slices1;
+  std::vector<fptype> slices2;
+  std::vector<fptype> transposed;
+  std::vector<fptype> pairResults;
+  std::vector<fptype> scratch;
+};
+
+#endif
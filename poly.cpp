@@ -0,0 +1,423 @@
+
+#include "numerictester.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+#include "horner.hpp"
+
+#include <algorithm>
+#include <random>
+#include <typeinfo>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <time.h>
+
+/* The precision of the statistics; the references use
+ * PolyCase::referencePrecision
+ */
+constexpr const unsigned statBits = 1024;
+
+/* A polynomial with degree roots drawn uniformly from
+ * [-1, 1], whose coefficients are the exact expansion of
+ * the product of (x - root), rounded to fptype.
+ * The points are either uniform in [-1, 1], or within a
+ * few ulps of a random root, where the evaluation is
+ * ill conditioned.
+ * Each point has its own MPFR reference for the rounded
+ * coefficients, and is added to the statistics separately.
+ * The expansion and the references are computed with
+ * enough bits to be exact for the degree, as the products
+ * of degree factors need about the factors' significand
+ * bits each
+ */
+template <typename fptype>
+class PolyCase : public NumericTester::TestCase {
+ public:
+  PolyCase(std::mt19937_64 &rgen,
+           std::uniform_real_distribution<fptype> &dist,
+           unsigned degree, unsigned numPoints,
+           bool nearRoot)
+      : NumericTester::TestCase(),
+        coeffs(degree + 1),
+        points(numPoints),
+        correctValues(numPoints),
+        degree(degree) {
+    std::vector<fptype> roots(degree);
+    for(auto &root : roots) root = dist(rgen);
+    const mpfr_prec_t expansionPrec =
+        expansionPrecision(roots);
+    std::vector<mpfr::mpreal> expanded(
+        degree + 1, mpfr::mpreal(0.0, expansionPrec));
+    expanded[0] = 1.0;
+    beginExactReference();
+    for(unsigned r = 0; r < degree; r++) {
+      for(unsigned i = r + 1; i > 0; i--)
+        expanded[i] =
+            expanded[i - 1] - expanded[i] * roots[r];
+      expanded[0] *= -roots[r];
+    }
+    endExactReference();
+    for(unsigned i = 0; i <= degree; i++)
+      coeffs[i] = (fptype)expanded[i];
+    constexpr const int maxUlps = 64;
+    constexpr const fptype eps =
+        GenericFP::fpconvert<fptype>::epsilon;
+    std::uniform_int_distribution<unsigned> whichRoot(
+        0, degree - 1);
+    std::uniform_int_distribution<int> ulps(-maxUlps,
+                                            maxUlps);
+    for(auto &point : points) {
+      if(nearRoot) {
+        const fptype root = roots[whichRoot(rgen)];
+        point = root + ulps(rgen) * std::fabs(root) * eps;
+      } else {
+        point = dist(rgen);
+      }
+    }
+    const mpfr_prec_t prec = referencePrecision();
+    beginExactReference();
+    for(unsigned p = 0; p < numPoints; p++) {
+      mpfr::mpreal accumulator(coeffs[degree], prec);
+      for(unsigned i = degree; i-- > 0;) {
+        accumulator *= points[p];
+        accumulator += coeffs[i];
+      }
+      correctValues[p] = accumulator;
+    }
+    endExactReference();
+    correct = correctValues[0];
+  }
+
+  std::vector<fptype> coeffs;
+  std::vector<fptype> points;
+  std::vector<mpfr::mpreal> correctValues;
+  const unsigned degree;
+
+ private:
+  /* Widens ulpExp and maxExp to hold every value in vals */
+  static void includeExponents(
+      const std::vector<fptype> &vals, long &ulpExp,
+      long &maxExp) {
+    for(fptype val : vals) {
+      if(val == 0) continue;
+      const int exp = std::ilogb(val) + 1;
+      ulpExp = std::min(
+          ulpExp, NumericTester::ulpExponent<fptype>(exp));
+      maxExp = std::max<long>(maxExp, exp);
+    }
+  }
+
+  /* The least precision which holds the expansion
+   * exactly; coefficient i sums degree choose i products
+   * of degree roots, which is at most 2^degree terms
+   */
+  mpfr_prec_t expansionPrecision(
+      const std::vector<fptype> &roots) const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    includeExponents(roots, ulpExp, maxExp);
+    return NumericTester::exactPrecision(ulpExp, maxExp,
+                                         degree, 1) +
+           degree;
+  }
+
+  /* The least precision which holds the value at every
+   * point exactly; it sums degree + 1 products of a
+   * coefficient and up to degree coordinates
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    includeExponents(coeffs, ulpExp, maxExp);
+    includeExponents(points, ulpExp, maxExp);
+    return NumericTester::exactPrecision(
+        ulpExp, maxExp, degree + 1, degree + 1);
+  }
+};
+
+/* Use the Curiously Recurring Template Pattern (CRTP)
+ * to implement static polymorphism here.
+ * Points whose exact value is 0 have no relative error,
+ * so they are left out of the statistics.
+ * Throughput is reported as millions of points evaluated
+ * per second
+ */
+template <typename fptype, typename derived>
+class PolyTestInterface
+    : public NumericTester::NumericTest {
+ public:
+  PolyTestInterface(bool nearRoot)
+      : NumericTester::NumericTest(),
+        nearRoot(nearRoot),
+        result(),
+        evaluations(0.0) {}
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const PolyCase<fptype>));
+    const PolyCase<fptype> *polyCase =
+        static_cast<const PolyCase<fptype> *>(&testCase);
+    result.resize(polyCase->points.size());
+    startTimer();
+    static_cast<derived *>(this)->runTest(polyCase,
+                                          result.data());
+    stopTimer();
+    evaluations += result.size();
+    for(unsigned p = 0; p < result.size(); p++) {
+      const mpfr::mpreal &correct =
+          polyCase->correctValues[p];
+      if(correct == 0) continue;
+      mpfr::mpreal estimate(result[p]);
+      addStatistic(estimate, correct);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Million Points/s: "
+        << evaluations / seconds / 1e6 << "\n";
+  }
+
+ protected:
+  static std::string precisionName() {
+    return GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  std::string pointsName() const {
+    return nearRoot ? " near Roots" : " at Random Points";
+  }
+
+  const bool nearRoot;
+  std::vector<fptype> result;
+  double evaluations;
+};
+
+template <typename fptype>
+class PolyHornerTest
+    : public PolyTestInterface<fptype,
+                               PolyHornerTest<fptype>> {
+ public:
+  PolyHornerTest(bool nearRoot)
+      : PolyTestInterface<fptype,
+                          PolyHornerTest<fptype>>(
+            nearRoot) {}
+
+  virtual std::string testName() {
+    return std::string("Horner with ") +
+           this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    for(unsigned p = 0; p < polyCase->points.size(); p++)
+      result[p] = horner(polyCase->coeffs.data(),
+                         polyCase->degree,
+                         polyCase->points[p]);
+  }
+};
+
+template <typename fptype>
+class PolyFMAHornerTest
+    : public PolyTestInterface<
+          fptype, PolyFMAHornerTest<fptype>> {
+ public:
+  PolyFMAHornerTest(bool nearRoot)
+      : PolyTestInterface<fptype,
+                          PolyFMAHornerTest<fptype>>(
+            nearRoot) {}
+
+  virtual std::string testName() {
+    return std::string("FMA Horner with ") +
+           this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    for(unsigned p = 0; p < polyCase->points.size(); p++)
+      result[p] = fmaHorner(polyCase->coeffs.data(),
+                            polyCase->degree,
+                            polyCase->points[p]);
+  }
+};
+
+template <typename fptype>
+class PolyCompHornerTest
+    : public PolyTestInterface<
+          fptype, PolyCompHornerTest<fptype>> {
+ public:
+  PolyCompHornerTest(bool nearRoot)
+      : PolyTestInterface<fptype,
+                          PolyCompHornerTest<fptype>>(
+            nearRoot) {}
+
+  virtual std::string testName() {
+    return std::string("CompHorner with ") +
+           this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    for(unsigned p = 0; p < polyCase->points.size(); p++)
+      result[p] = compHorner(polyCase->coeffs.data(),
+                             polyCase->degree,
+                             polyCase->points[p]);
+  }
+};
+
+template <typename fptype>
+class PolyKFoldHornerTest
+    : public PolyTestInterface<
+          fptype, PolyKFoldHornerTest<fptype>> {
+ public:
+  PolyKFoldHornerTest(bool nearRoot, unsigned K)
+      : PolyTestInterface<fptype,
+                          PolyKFoldHornerTest<fptype>>(
+            nearRoot),
+        kFold(K) {}
+
+  virtual std::string testName() {
+    return std::to_string(kFold.folds()) +
+           " Fold Horner with " + this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    for(unsigned p = 0; p < polyCase->points.size(); p++)
+      result[p] = kFold.evaluate(polyCase->coeffs.data(),
+                                 polyCase->degree,
+                                 polyCase->points[p]);
+  }
+
+ private:
+  KFoldHorner<fptype> kFold;
+};
+
+template <typename fptype>
+class PolyHornerSIMDTest
+    : public PolyTestInterface<
+          fptype, PolyHornerSIMDTest<fptype>> {
+ public:
+  PolyHornerSIMDTest(bool nearRoot)
+      : PolyTestInterface<fptype,
+                          PolyHornerSIMDTest<fptype>>(
+            nearRoot) {}
+
+  virtual std::string testName() {
+    return std::string("SIMD Horner with ") +
+           this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    hornerSIMD(polyCase->coeffs.data(), polyCase->degree,
+               polyCase->points.data(), result,
+               polyCase->points.size());
+  }
+};
+
+template <typename fptype>
+class PolyCompHornerSIMDTest
+    : public PolyTestInterface<
+          fptype, PolyCompHornerSIMDTest<fptype>> {
+ public:
+  PolyCompHornerSIMDTest(bool nearRoot)
+      : PolyTestInterface<fptype,
+                          PolyCompHornerSIMDTest<fptype>>(
+            nearRoot) {}
+
+  virtual std::string testName() {
+    return std::string("SIMD CompHorner with ") +
+           this->precisionName() +
+           this->pointsName();
+  }
+
+  void __attribute__((noinline))
+  runTest(const PolyCase<fptype> *polyCase,
+          fptype *result) {
+    compHornerSIMD(polyCase->coeffs.data(),
+                   polyCase->degree,
+                   polyCase->points.data(), result,
+                   polyCase->points.size());
+  }
+};
+
+template <typename fptype>
+void runTests(std::mt19937_64 &engine, const int numTests,
+              const unsigned degree,
+              const unsigned numPoints, bool nearRoot) {
+  NumericTester::NumericTest *tests[] = {
+      new PolyHornerTest<fptype>(nearRoot),
+      new PolyFMAHornerTest<fptype>(nearRoot),
+      new PolyCompHornerTest<fptype>(nearRoot),
+      new PolyKFoldHornerTest<fptype>(nearRoot, 3),
+      new PolyHornerSIMDTest<fptype>(nearRoot),
+      new PolyCompHornerSIMDTest<fptype>(nearRoot)};
+  std::uniform_real_distribution<fptype> rgenf(-1.0, 1.0);
+  for(int i = 0; i < numTests; i++) {
+    PolyCase<fptype> testcase(engine, rgenf, degree,
+                              numPoints, nearRoot);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+int main(int argc, char **argv) {
+  int numTests = 256;
+  int degree = 10;
+  int numPoints = 256;
+  if(argc > 1) {
+    numTests = atoi(argv[1]);
+    if(numTests < 1) {
+      printf("Number of tests must be greater than 0\n");
+      return -1;
+    }
+    if(argc > 2) {
+      degree = atoi(argv[2]);
+      if(degree < 1) {
+        printf("Degree must be greater than 0\n");
+        return -1;
+      }
+      if(argc > 3) {
+        numPoints = atoi(argv[3]);
+        if(numPoints < 1) {
+          printf(
+              "Number of points must be greater than 0\n");
+          return -1;
+        }
+      }
+    }
+  }
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  for(bool nearRoot : {false, true}) {
+    runTests<float>(engine, numTests, degree, numPoints,
+                    nearRoot);
+    runTests<double>(engine, numTests, degree, numPoints,
+                     nearRoot);
+  }
+  return 0;
+}
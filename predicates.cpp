@@ -0,0 +1,364 @@
+
+#include "numerictester.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+#include "predicates.hpp"
+
+#include <algorithm>
+#include <random>
+#include <type_traits>
+#include <typeinfo>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <time.h>
+
+/* The precision of the statistics; the references use
+ * PredicateCase::referencePrecision
+ */
+constexpr const unsigned statBits = 1024;
+
+/* A batch of point sets for a predicate.
+ * Random sets have coordinates uniform in [-1, 1].
+ * Near degenerate sets are computed in double precision
+ * and then rounded, so the rounding decides their sign:
+ * the last point of an orientation predicate is an affine
+ * combination of the others, and the points of an
+ * incircle or insphere predicate are on a random circle
+ * or sphere.
+ * Every set has an MPFR reference for its determinant
+ */
+template <typename fptype, typename predicate>
+class PredicateCase : public NumericTester::TestCase {
+ public:
+  static constexpr const unsigned dim = predicate::dim;
+  static constexpr const unsigned numPoints =
+      predicate::numPoints;
+  static constexpr const unsigned setSize =
+      dim * numPoints;
+
+  PredicateCase(std::mt19937_64 &rgen, unsigned numSets,
+                bool degenerate)
+      : NumericTester::TestCase(),
+        points(numSets * setSize),
+        correctDets(numSets) {
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    for(unsigned s = 0; s < numSets; s++) {
+      fptype *pts = points.data() + s * setSize;
+      if(!degenerate) {
+        for(unsigned i = 0; i < setSize; i++)
+          pts[i] = unit(rgen);
+      } else if(!predicate::lifted) {
+        double weights[dim], last[dim] = {};
+        double weightSum = 0.0;
+        for(unsigned i = 0; i < dim - 1; i++) {
+          weights[i] = unit(rgen);
+          weightSum += weights[i];
+        }
+        weights[dim - 1] = 1.0 - weightSum;
+        for(unsigned i = 0; i < dim; i++) {
+          for(unsigned j = 0; j < dim; j++) {
+            const double coord = unit(rgen);
+            pts[i * dim + j] = coord;
+            last[j] += weights[i] * coord;
+          }
+        }
+        for(unsigned j = 0; j < dim; j++)
+          pts[dim * dim + j] = last[j];
+      } else {
+        std::normal_distribution<double> normal;
+        double center[dim];
+        for(unsigned j = 0; j < dim; j++)
+          center[j] = unit(rgen) / 2;
+        const double radius =
+            0.5 + std::fabs(unit(rgen)) / 2;
+        for(unsigned i = 0; i < numPoints; i++) {
+          double dir[dim], norm = 0.0;
+          for(unsigned j = 0; j < dim; j++) {
+            dir[j] = normal(rgen);
+            norm += dir[j] * dir[j];
+          }
+          norm = std::sqrt(norm);
+          for(unsigned j = 0; j < dim; j++)
+            pts[i * dim + j] =
+                center[j] + radius * dir[j] / norm;
+        }
+      }
+    }
+    const mpfr_prec_t prec = referencePrecision();
+    beginExactReference();
+    for(unsigned s = 0; s < numSets; s++)
+      correctDets[s] = referenceDeterminant(
+          points.data() + s * setSize, prec);
+    endExactReference();
+    correct = correctDets[0];
+  }
+
+  unsigned size() const { return correctDets.size(); }
+
+  std::vector<fptype> points;
+  std::vector<mpfr::mpreal> correctDets;
+
+ private:
+  static constexpr const unsigned rows = numPoints - 1;
+
+  /* The least precision which holds every determinant
+   * exactly; its entries are differences of coordinates,
+   * with the coordinates' ulp and one more bit, or lifts
+   * which sum dim squares of differences, so it sums rows!
+   * products of rows differences, or dim rows! products of
+   * rows + 1 differences when lifted
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    for(fptype coord : points) {
+      if(coord == 0) continue;
+      const int exp = std::ilogb(coord) + 1;
+      ulpExp = std::min(
+          ulpExp, NumericTester::ulpExponent<fptype>(exp));
+      maxExp = std::max<long>(maxExp, exp);
+    }
+    unsigned long numTerms = predicate::lifted ? dim : 1;
+    for(unsigned i = 2; i <= rows; i++) numTerms *= i;
+    return NumericTester::exactPrecision(
+        ulpExp, maxExp + 1, rows + predicate::lifted,
+        numTerms);
+  }
+
+  static mpfr::mpreal referenceDeterminant(
+      const fptype *pts, mpfr_prec_t prec) {
+    std::vector<std::vector<mpfr::mpreal>> m(rows);
+    for(unsigned i = 0; i < rows; i++) {
+      mpfr::mpreal lift(0.0, prec);
+      for(unsigned j = 0; j < dim; j++) {
+        mpfr::mpreal diff(pts[i * dim + j], prec);
+        diff -= pts[rows * dim + j];
+        lift += diff * diff;
+        m[i].push_back(diff);
+      }
+      if(predicate::lifted) m[i].push_back(lift);
+    }
+    return determinant(m);
+  }
+
+  static mpfr::mpreal determinant(
+      const std::vector<std::vector<mpfr::mpreal>> &m) {
+    const unsigned n = m.size();
+    if(n == 1) return m[0][0];
+    mpfr::mpreal det(0.0, m[0][0].get_prec());
+    for(unsigned c = 0; c < n; c++) {
+      std::vector<std::vector<mpfr::mpreal>> sub(n - 1);
+      for(unsigned r = 1; r < n; r++) {
+        for(unsigned k = 0; k < n; k++) {
+          if(k != c) sub[r - 1].push_back(m[r][k]);
+        }
+      }
+      const mpfr::mpreal term = m[0][c] * determinant(sub);
+      if(c % 2 == 0)
+        det += term;
+      else
+        det -= term;
+    }
+    return det;
+  }
+};
+
+/* The evaluators run a single stage of the predicate,
+ * to measure its cost, or the adaptive predicate
+ */
+
+struct FilterEvaluator {
+  static constexpr const char *name = "Floating Point";
+  template <typename predicate, typename fptype>
+  static fptype evaluate(const fptype *pts,
+                         PredicateStage &stage) {
+    fptype permanent;
+    stage = PredicateStage::filter;
+    return predicate::fast(pts, permanent);
+  }
+};
+
+struct RoundedEvaluator {
+  static constexpr const char *name = "Rounded Expansion";
+  template <typename predicate, typename fptype>
+  static fptype evaluate(const fptype *pts,
+                         PredicateStage &stage) {
+    bool exactDiffs;
+    stage = PredicateStage::adaptive;
+    return expansionEstimate(predicateExpansion<predicate>(
+        pts, false, exactDiffs));
+  }
+};
+
+struct ExactEvaluator {
+  static constexpr const char *name = "Exact Expansion";
+  template <typename predicate, typename fptype>
+  static fptype evaluate(const fptype *pts,
+                         PredicateStage &stage) {
+    stage = PredicateStage::exact;
+    return exactPredicate<predicate>(pts);
+  }
+};
+
+struct AdaptiveEvaluator {
+  static constexpr const char *name = "Adaptive";
+  template <typename predicate, typename fptype>
+  static fptype evaluate(const fptype *pts,
+                         PredicateStage &stage) {
+    return adaptivePredicate<predicate>(pts, stage);
+  }
+};
+
+/* Only the signs are checked, with the magnitude of the
+ * exact determinant as the distance from degeneracy.
+ * The stage which decided every sign is counted, and for
+ * the adaptive evaluator, the filter failure rate is the
+ * fraction of sets which the filter couldn't decide
+ */
+template <typename fptype, typename predicate,
+          typename evaluator>
+class PredicateTest : public NumericTester::NumericTest {
+ public:
+  PredicateTest(bool degenerate)
+      : NumericTester::NumericTest(true),
+        degenerate(degenerate),
+        stageCounts(),
+        sets(0.0),
+        dets(),
+        stages() {}
+
+  virtual std::string testName() {
+    return std::string(evaluator::name) + " " +
+           predicate::name + " with " +
+           GenericFP::fpconvert<fptype>::fpname +
+           (degenerate ? " near Degenerate Points"
+                       : " at Random Points");
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    using casetype = PredicateCase<fptype, predicate>;
+    assert(typeid(testCase) == typeid(const casetype));
+    const casetype *pCase =
+        static_cast<const casetype *>(&testCase);
+    const unsigned size = pCase->size();
+    dets.resize(size);
+    stages.resize(size);
+    startTimer();
+    runTest(pCase->points.data(), size);
+    stopTimer();
+    sets += size;
+    for(unsigned s = 0; s < size; s++) {
+      stageCounts[(int)stages[s]]++;
+      const mpfr::mpreal &correct = pCase->correctDets[s];
+      addSignStatistic(mpfr::mpreal(dets[s]), correct,
+                       mpfr::abs(correct));
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    const char *stageNames[] = {"Filter", "Adaptive Stage",
+                                "Exact Stage"};
+    for(unsigned i = 0; i < numStages; i++)
+      out << "Decided by " << stageNames[i] << ": "
+          << stageCounts[i] << "\n";
+    if(std::is_same<evaluator, AdaptiveEvaluator>::value) {
+      out << "Filter Failure Rate: "
+          << (sets - stageCounts[0]) / sets << "\n";
+    }
+    out << "Nanoseconds/Predicate: " << seconds / sets * 1e9
+        << "\n"
+        << "Million Predicates/s: " << sets / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  void __attribute__((noinline))
+  runTest(const fptype *points, unsigned size) {
+    constexpr const unsigned setSize =
+        PredicateCase<fptype, predicate>::setSize;
+    for(unsigned s = 0; s < size; s++)
+      dets[s] = evaluator::template evaluate<predicate>(
+          points + s * setSize, stages[s]);
+  }
+
+  static constexpr const unsigned numStages = 3;
+  const bool degenerate;
+  unsigned long stageCounts[numStages];
+  double sets;
+  std::vector<fptype> dets;
+  std::vector<PredicateStage> stages;
+};
+
+template <typename fptype, typename predicate>
+void runTests(std::mt19937_64 &engine, const int numTests,
+              const unsigned numSets, bool degenerate) {
+  NumericTester::NumericTest *tests[] = {
+      new PredicateTest<fptype, predicate,
+                        FilterEvaluator>(degenerate),
+      new PredicateTest<fptype, predicate,
+                        RoundedEvaluator>(degenerate),
+      new PredicateTest<fptype, predicate,
+                        ExactEvaluator>(degenerate),
+      new PredicateTest<fptype, predicate,
+                        AdaptiveEvaluator>(degenerate)};
+  for(int i = 0; i < numTests; i++) {
+    PredicateCase<fptype, predicate> testcase(
+        engine, numSets, degenerate);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+template <typename predicate>
+void runPredicateTests(std::mt19937_64 &engine,
+                       const int numTests,
+                       const unsigned numSets) {
+  for(bool degenerate : {false, true}) {
+    runTests<float, predicate>(engine, numTests, numSets,
+                               degenerate);
+    runTests<double, predicate>(engine, numTests, numSets,
+                                degenerate);
+  }
+}
+
+int main(int argc, char **argv) {
+  int numTests = 256;
+  int numSets = 1024;
+  if(argc > 1) {
+    numTests = atoi(argv[1]);
+    if(numTests < 1) {
+      printf("Number of tests must be greater than 0\n");
+      return -1;
+    }
+    if(argc > 2) {
+      numSets = atoi(argv[2]);
+      if(numSets < 1) {
+        printf("Batch size must be greater than 0\n");
+        return -1;
+      }
+    }
+  }
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  runPredicateTests<Orient2d>(engine, numTests, numSets);
+  runPredicateTests<Orient3d>(engine, numTests, numSets);
+  runPredicateTests<InCircle>(engine, numTests, numSets);
+  runPredicateTests<InSphere>(engine, numTests, numSets);
+  return 0;
+}
@@ -0,0 +1,406 @@
+
+#ifndef _PREDICATES_HPP_
+#define _PREDICATES_HPP_
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+
+/* Shewchuk's adaptive precision geometric predicates.
+ * Each predicate is the sign of a determinant of the
+ * differences of its points from the last point,
+ * optionally with a lifted column of squared lengths.
+ * The determinant is computed in stages:
+ *  - the filter, which is the plain floating point
+ *    determinant, accepted when its magnitude exceeds an
+ *    a priori error bound,
+ *  - the adaptive stage, the exact determinant of the
+ *    rounded differences, computed with expansions and
+ *    accepted under a tighter error bound, or when the
+ *    differences were exact,
+ *  - the exact stage, the determinant of the exact
+ *    differences, computed with expansions.
+ * The error bounds are Shewchuk's, and are valid for any
+ * binary format with round to nearest, unless there is
+ * underflow or overflow
+ */
+
+/* A nonoverlapping expansion: an unevaluated sum of
+ * components in increasing magnitude, without zeros
+ * except in a zero expansion, which is either empty or a
+ * single 0
+ */
+template <typename fptype>
+using Expansion = std::vector<fptype>;
+
+/* Shewchuk's fast expansion sum with zero elimination:
+ * the components are merged by magnitude, and summed with
+ * TwoSum from the smallest up
+ */
+template <typename fptype>
+Expansion<fptype> expansionSum(const Expansion<fptype> &e,
+                               const Expansion<fptype> &f) {
+  if(e.empty()) return f;
+  if(f.empty()) return e;
+  Expansion<fptype> h;
+  h.reserve(e.size() + f.size());
+  unsigned ei = 0, fi = 0;
+  auto next = [&]() {
+    if(fi == f.size() ||
+       (ei < e.size() &&
+        std::fabs(e[ei]) < std::fabs(f[fi])))
+      return e[ei++];
+    return f[fi++];
+  };
+  fptype q = next();
+  while(ei < e.size() || fi < f.size()) {
+    std::array<fptype, 2> sum = twoSum(q, next());
+    q = sum[0];
+    if(sum[1] != 0.0) h.push_back(sum[1]);
+  }
+  if(q != 0.0 || h.empty()) h.push_back(q);
+  return h;
+}
+
+/* Shewchuk's scale expansion with zero elimination */
+template <typename fptype>
+Expansion<fptype> scaleExpansion(const Expansion<fptype> &e,
+                                 fptype b) {
+  Expansion<fptype> h;
+  if(e.empty() || b == 0.0) return h;
+  h.reserve(2 * e.size());
+  std::array<fptype, 2> prod = twoProd(e[0], b);
+  fptype q = prod[0];
+  if(prod[1] != 0.0) h.push_back(prod[1]);
+  for(unsigned i = 1; i < e.size(); i++) {
+    prod = twoProd(e[i], b);
+    std::array<fptype, 2> sum = twoSum(q, prod[1]);
+    if(sum[1] != 0.0) h.push_back(sum[1]);
+    sum = twoSum(prod[0], sum[0]);
+    q = sum[0];
+    if(sum[1] != 0.0) h.push_back(sum[1]);
+  }
+  if(q != 0.0 || h.empty()) h.push_back(q);
+  return h;
+}
+
+template <typename fptype>
+Expansion<fptype> expansionProduct(
+    const Expansion<fptype> &e,
+    const Expansion<fptype> &f) {
+  Expansion<fptype> h;
+  for(fptype component : f)
+    h = expansionSum(h, scaleExpansion(e, component));
+  return h;
+}
+
+/* Approximates the expansion by summing its components
+ * from the smallest up
+ */
+template <typename fptype>
+fptype expansionEstimate(const Expansion<fptype> &e) {
+  fptype sum = 0.0;
+  for(fptype component : e) sum += component;
+  return sum;
+}
+
+/* The determinant of an n x n matrix of expansions by
+ * cofactor expansion along the first row
+ */
+template <typename fptype>
+Expansion<fptype> expansionDeterminant(
+    const std::vector<std::vector<Expansion<fptype>>> &m) {
+  const unsigned n = m.size();
+  if(n == 1) return m[0][0];
+  Expansion<fptype> det;
+  for(unsigned c = 0; c < n; c++) {
+    if(m[0][c].empty()) continue;
+    std::vector<std::vector<Expansion<fptype>>> sub(n - 1);
+    for(unsigned r = 1; r < n; r++) {
+      for(unsigned k = 0; k < n; k++) {
+        if(k != c) sub[r - 1].push_back(m[r][k]);
+      }
+    }
+    Expansion<fptype> term = expansionProduct(
+        m[0][c], expansionDeterminant(sub));
+    if(c % 2 == 1) {
+      for(auto &component : term) component = -component;
+    }
+    det = expansionSum(det, term);
+  }
+  return det;
+}
+
+/* The stage which decided the sign of a predicate */
+enum class PredicateStage { filter, adaptive, exact };
+
+/* Shewchuk's error bounds are (c0 + c1 eps) eps, with eps
+ * the unit roundoff
+ */
+template <typename fptype>
+fptype predicateBound(fptype c0, fptype c1) {
+  const fptype eps = unitRoundoff<fptype>();
+  return (c0 + c1 * eps) * eps;
+}
+
+/* The predicates' points are stored contiguously,
+ * pts[i * dim + j] being coordinate j of point i.
+ * fast returns the floating point determinant, and the
+ * permanent which scales the error bounds
+ */
+
+/* Positive when a, b, c are in counterclockwise order */
+struct Orient2d {
+  static constexpr const char *name = "Orient2D";
+  static constexpr const unsigned dim = 2;
+  static constexpr const unsigned numPoints = 3;
+  static constexpr const bool lifted = false;
+
+  template <typename fptype>
+  static fptype boundA() {
+    return predicateBound<fptype>(3.0, 16.0);
+  }
+
+  template <typename fptype>
+  static fptype boundB() {
+    return predicateBound<fptype>(2.0, 12.0);
+  }
+
+  template <typename fptype>
+  static fptype fast(const fptype *pts, fptype &permanent) {
+    const fptype *pa = pts, *pb = pts + 2, *pc = pts + 4;
+    const fptype detLeft =
+        (pa[0] - pc[0]) * (pb[1] - pc[1]);
+    const fptype detRight =
+        (pa[1] - pc[1]) * (pb[0] - pc[0]);
+    permanent = std::fabs(detLeft) + std::fabs(detRight);
+    return detLeft - detRight;
+  }
+};
+
+/* Positive when d is below the plane of a, b, c, which
+ * appear counterclockwise from above it
+ */
+struct Orient3d {
+  static constexpr const char *name = "Orient3D";
+  static constexpr const unsigned dim = 3;
+  static constexpr const unsigned numPoints = 4;
+  static constexpr const bool lifted = false;
+
+  template <typename fptype>
+  static fptype boundA() {
+    return predicateBound<fptype>(7.0, 56.0);
+  }
+
+  template <typename fptype>
+  static fptype boundB() {
+    return predicateBound<fptype>(3.0, 28.0);
+  }
+
+  template <typename fptype>
+  static fptype fast(const fptype *pts, fptype &permanent) {
+    const fptype *pa = pts, *pb = pts + 3, *pc = pts + 6,
+                 *pd = pts + 9;
+    const fptype adx = pa[0] - pd[0], ady = pa[1] - pd[1],
+                 adz = pa[2] - pd[2];
+    const fptype bdx = pb[0] - pd[0], bdy = pb[1] - pd[1],
+                 bdz = pb[2] - pd[2];
+    const fptype cdx = pc[0] - pd[0], cdy = pc[1] - pd[1],
+                 cdz = pc[2] - pd[2];
+    const fptype bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const fptype cdxady = cdx * ady, adxcdy = adx * cdy;
+    const fptype adxbdy = adx * bdy, bdxady = bdx * ady;
+    permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) *
+                    std::fabs(adz) +
+                (std::fabs(cdxady) + std::fabs(adxcdy)) *
+                    std::fabs(bdz) +
+                (std::fabs(adxbdy) + std::fabs(bdxady)) *
+                    std::fabs(cdz);
+    return adz * (bdxcdy - cdxbdy) +
+           bdz * (cdxady - adxcdy) +
+           cdz * (adxbdy - bdxady);
+  }
+};
+
+/* Positive when d is inside the circle through a, b, c,
+ * which are in counterclockwise order
+ */
+struct InCircle {
+  static constexpr const char *name = "InCircle";
+  static constexpr const unsigned dim = 2;
+  static constexpr const unsigned numPoints = 4;
+  static constexpr const bool lifted = true;
+  template <typename fptype>
+  static fptype boundA() {
+    return predicateBound<fptype>(10.0, 96.0);
+  }
+
+  template <typename fptype>
+  static fptype boundB() {
+    return predicateBound<fptype>(4.0, 48.0);
+  }
+
+  template <typename fptype>
+  static fptype fast(const fptype *pts, fptype &permanent) {
+    const fptype *pa = pts, *pb = pts + 2, *pc = pts + 4,
+                 *pd = pts + 6;
+    const fptype adx = pa[0] - pd[0], ady = pa[1] - pd[1];
+    const fptype bdx = pb[0] - pd[0], bdy = pb[1] - pd[1];
+    const fptype cdx = pc[0] - pd[0], cdy = pc[1] - pd[1];
+    const fptype bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const fptype alift = adx * adx + ady * ady;
+    const fptype cdxady = cdx * ady, adxcdy = adx * cdy;
+    const fptype blift = bdx * bdx + bdy * bdy;
+    const fptype adxbdy = adx * bdy, bdxady = bdx * ady;
+    const fptype clift = cdx * cdx + cdy * cdy;
+    permanent =
+        (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift +
+        (std::fabs(cdxady) + std::fabs(adxcdy)) * blift +
+        (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+    return alift * (bdxcdy - cdxbdy) +
+           blift * (cdxady - adxcdy) +
+           clift * (adxbdy - bdxady);
+  }
+};
+
+/* Positive when e is inside the sphere through a, b, c, d,
+ * which have a positive orientation
+ */
+struct InSphere {
+  static constexpr const char *name = "InSphere";
+  static constexpr const unsigned dim = 3;
+  static constexpr const unsigned numPoints = 5;
+  static constexpr const bool lifted = true;
+  template <typename fptype>
+  static fptype boundA() {
+    return predicateBound<fptype>(16.0, 224.0);
+  }
+
+  template <typename fptype>
+  static fptype boundB() {
+    return predicateBound<fptype>(5.0, 72.0);
+  }
+
+  template <typename fptype>
+  static fptype fast(const fptype *pts, fptype &permanent) {
+    const fptype *pe = pts + 12;
+    fptype ex[4], ey[4], ez[4], lift[4];
+    for(unsigned i = 0; i < 4; i++) {
+      ex[i] = pts[3 * i] - pe[0];
+      ey[i] = pts[3 * i + 1] - pe[1];
+      ez[i] = pts[3 * i + 2] - pe[2];
+      lift[i] = ex[i] * ex[i] + ey[i] * ey[i] +
+                ez[i] * ez[i];
+    }
+    /* xy[i][j] = ex[i] ey[j], so the 2x2 minors are
+     * xy[i][j] - xy[j][i]
+     */
+    fptype xy[4][4];
+    for(unsigned i = 0; i < 4; i++) {
+      for(unsigned j = 0; j < 4; j++)
+        xy[i][j] = ex[i] * ey[j];
+    }
+    auto det2 = [&](unsigned i, unsigned j) {
+      return xy[i][j] - xy[j][i];
+    };
+    auto perm2 = [&](unsigned i, unsigned j) {
+      return std::fabs(xy[i][j]) + std::fabs(xy[j][i]);
+    };
+    const fptype ab = det2(0, 1), bc = det2(1, 2),
+                 cd = det2(2, 3), da = det2(3, 0),
+                 ac = det2(0, 2), bd = det2(1, 3);
+    const fptype abc = ez[0] * bc - ez[1] * ac + ez[2] * ab;
+    const fptype bcd = ez[1] * cd - ez[2] * bd + ez[3] * bc;
+    const fptype cda = ez[2] * da + ez[3] * ac + ez[0] * cd;
+    const fptype dab = ez[3] * ab + ez[0] * bd + ez[1] * da;
+    fptype z[4];
+    for(unsigned i = 0; i < 4; i++) z[i] = std::fabs(ez[i]);
+    permanent = ((perm2(2, 3) * z[1] + perm2(3, 1) * z[2] +
+                  perm2(1, 2) * z[3]) *
+                     lift[0] +
+                 (perm2(3, 0) * z[2] + perm2(0, 2) * z[3] +
+                  perm2(2, 3) * z[0]) *
+                     lift[1] +
+                 (perm2(0, 1) * z[3] + perm2(1, 3) * z[0] +
+                  perm2(3, 0) * z[1]) *
+                     lift[2] +
+                 (perm2(1, 2) * z[0] + perm2(2, 0) * z[1] +
+                  perm2(0, 1) * z[2]) *
+                     lift[3]);
+    return (lift[3] * abc - lift[2] * dab) +
+           (lift[1] * cda - lift[0] * bcd);
+  }
+};
+
+/* The determinant of the differences from the last point
+ * as an expansion, with either exact or rounded
+ * differences.
+ * Sets exactDiffs to whether every rounded difference
+ * was exact
+ */
+template <typename predicate, typename fptype>
+Expansion<fptype> predicateExpansion(const fptype *pts,
+                                     bool exact,
+                                     bool &exactDiffs) {
+  constexpr const unsigned dim = predicate::dim;
+  constexpr const unsigned rows = predicate::numPoints - 1;
+  const fptype *last = pts + rows * dim;
+  exactDiffs = true;
+  std::vector<std::vector<Expansion<fptype>>> m(rows);
+  for(unsigned i = 0; i < rows; i++) {
+    Expansion<fptype> lift;
+    for(unsigned j = 0; j < dim; j++) {
+      std::array<fptype, 2> diff =
+          twoSum(pts[i * dim + j], -last[j]);
+      if(diff[1] != 0.0) exactDiffs = false;
+      Expansion<fptype> entry;
+      if(exact && diff[1] != 0.0) entry.push_back(diff[1]);
+      if(diff[0] != 0.0) entry.push_back(diff[0]);
+      if(predicate::lifted)
+        lift = expansionSum(lift,
+                            expansionProduct(entry, entry));
+      m[i].push_back(entry);
+    }
+    if(predicate::lifted) m[i].push_back(lift);
+  }
+  return expansionDeterminant(m);
+}
+
+template <typename predicate, typename fptype>
+fptype exactPredicate(const fptype *pts) {
+  bool exactDiffs;
+  return expansionEstimate(
+      predicateExpansion<predicate>(pts, true, exactDiffs));
+}
+
+/* The adaptive predicate, which writes the stage that
+ * decided the sign
+ */
+template <typename predicate, typename fptype>
+fptype adaptivePredicate(const fptype *pts,
+                         PredicateStage &stage) {
+  fptype permanent;
+  fptype det = predicate::fast(pts, permanent);
+  const fptype boundA =
+      predicate::template boundA<fptype>() * permanent;
+  if(det > boundA || -det > boundA) {
+    stage = PredicateStage::filter;
+    return det;
+  }
+  bool exactDiffs;
+  det = expansionEstimate(predicateExpansion<predicate>(
+      pts, false, exactDiffs));
+  const fptype boundB =
+      predicate::template boundB<fptype>() * permanent;
+  if(exactDiffs || det >= boundB || -det >= boundB) {
+    stage = PredicateStage::adaptive;
+    return det;
+  }
+  stage = PredicateStage::exact;
+  return exactPredicate<predicate>(pts);
+}
+
+#endif
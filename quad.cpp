@@ -1,11 +1,22 @@
 
 #include "numerictester.hpp"
+#include "genericfp.hpp"
 #include "mpreal.h"
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "ray_quadric.hpp"
+#include "general_quadric.hpp"
+#include "quadric_batch.hpp"
+#include "interval.hpp"
 
 #include <random>
 #include <typeinfo>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
 
 #include <assert.h>
 #include <time.h>
@@ -20,10 +31,43 @@ class QuadricTestCase : public NumericTester::TestCase {
     }
     radius = 0.0;
   }
+
+  /* The distance from pos to the surface, whose value is
+   * the squared distance to its center minus radius^2
+   */
+  mpfr::mpreal surfaceDistance() const {
+    mpfr::mpreal r(radius);
+    return mpfr::abs(mpfr::sqrt(correct + r * r) - r);
+  }
+
+  /* The least precision which holds the correct value of
+   * every case with coordinates and radius of magnitude at
+   * most maxMag exactly; it sums dim + 1 squares of the
+   * radius and the sums of the coordinates, which are
+   * below 2 maxMag, with ulps of at least that of the
+   * smallest subnormal
+   */
+  static mpfr_prec_t referencePrecision(fptype maxMag) {
+    return NumericTester::exactPrecision(
+        NumericTester::ulpExponent<fptype>(
+            std::numeric_limits<fptype>::min_exponent),
+        std::ilogb(maxMag) + 2, 2, dim + 1);
+  }
+
   static constexpr const unsigned dim = 3;
   fptype pos[dim];
   fptype trans[dim];
   fptype radius;
+
+ protected:
+  /* Adds val^2 to the correct value in place, with one
+   * rounding
+   */
+  void addSquare(const mpfr::mpreal &val) {
+    mpfr_fma(correct.mpfr_ptr(), val.mpfr_srcptr(),
+             val.mpfr_srcptr(), correct.mpfr_srcptr(),
+             MPFR_RNDN);
+  }
 };
 
 template <typename fptype>
@@ -34,16 +78,18 @@ class SphereTransCase : public QuadricTestCase<fptype> {
       std::uniform_real_distribution<fptype> &dist)
       : QuadricTestCase<fptype>() {
     this->radius = std::fabs(dist(rgen));
+    this->beginExactReference();
     this->correct = -this->radius;
     this->correct *= this->radius;
+    mpfr::mpreal tmp;
     for(unsigned i = 0; i < this->dim; i++) {
       this->pos[i] = dist(rgen);
       this->trans[i] = dist(rgen);
-      mpfr::mpreal tmp(this->pos[i]);
+      tmp = this->pos[i];
       tmp += this->trans[i];
-      tmp *= tmp;
-      this->correct += tmp;
+      this->addSquare(tmp);
     }
+    this->endExactReference();
   }
 };
 
@@ -55,28 +101,34 @@ class AxisCylinderTransCase
       std::mt19937_64 &rgen,
       std::uniform_real_distribution<fptype> &dist)
       : QuadricTestCase<fptype>() {
-    unsigned axis =
-        ((unsigned)std::floor(dist(rgen))) % this->dim;
+    axis = ((unsigned)std::floor(dist(rgen))) % this->dim;
     this->radius = std::fabs(dist(rgen));
+    this->beginExactReference();
     this->correct = -this->radius;
     this->correct *= this->radius;
+    mpfr::mpreal tmp;
     for(unsigned i = 0; i < this->dim; i++) {
       if(i == axis)
         this->trans[i] = 0.0;
       else
         this->trans[i] = dist(rgen);
       this->pos[i] = dist(rgen);
-      mpfr::mpreal tmp(this->pos[i]);
+      tmp = this->pos[i];
       tmp += this->trans[i];
-      tmp *= tmp;
-      this->correct += tmp;
+      this->addSquare(tmp);
     }
+    this->endExactReference();
   }
+
+  unsigned axis;
 };
 
 template <typename fptype>
 class QuadNullTest : public NumericTester::NumericTest {
  public:
+  QuadNullTest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
   virtual std::string testName() {
     return std::string("Null Quadric Evaluation");
   }
@@ -91,13 +143,20 @@ class QuadNullTest : public NumericTester::NumericTest {
     fptype accumulator = NAN;
     stopTimer();
     mpfr::mpreal estimate(accumulator);
-    addStatistic(estimate, testCase.correctValue());
+    if(signMode)
+      addSignStatistic(estimate, testCase.correctValue(),
+                       stCase->surfaceDistance());
+    else
+      addStatistic(estimate, testCase.correctValue());
   }
 };
 
 template <typename fptype>
 class QuadNaiveTest : public NumericTester::NumericTest {
  public:
+  QuadNaiveTest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
   virtual std::string testName() {
     return std::string("Naive Quadric Evaluation");
   }
@@ -122,13 +181,20 @@ class QuadNaiveTest : public NumericTester::NumericTest {
     }
     stopTimer();
     mpfr::mpreal estimate(accumulator);
-    addStatistic(estimate, testCase.correctValue());
+    if(signMode)
+      addSignStatistic(estimate, testCase.correctValue(),
+                       stCase->surfaceDistance());
+    else
+      addStatistic(estimate, testCase.correctValue());
   }
 };
 
 template <typename fptype>
 class QuadFMATest : public NumericTester::NumericTest {
  public:
+  QuadFMATest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
   virtual std::string testName() {
     return std::string("FMA Quadric Evaluation");
   }
@@ -156,13 +222,20 @@ class QuadFMATest : public NumericTester::NumericTest {
     }
     stopTimer();
     mpfr::mpreal estimate(accumulator);
-    addStatistic(estimate, testCase.correctValue());
+    if(signMode)
+      addSignStatistic(estimate, testCase.correctValue(),
+                       stCase->surfaceDistance());
+    else
+      addStatistic(estimate, testCase.correctValue());
   }
 };
 
 template <typename fptype>
 class QuadKahanFMATest : public NumericTester::NumericTest {
  public:
+  QuadKahanFMATest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
   virtual std::string testName() {
     return std::string("Kahan FMA Quadric Evaluation");
   }
@@ -197,24 +270,190 @@ class QuadKahanFMATest : public NumericTester::NumericTest {
     }
     stopTimer();
     mpfr::mpreal estimate(accumulator);
-    addStatistic(estimate, testCase.correctValue());
+    if(signMode)
+      addSignStatistic(estimate, testCase.correctValue(),
+                       stCase->surfaceDistance());
+    else
+      addStatistic(estimate, testCase.correctValue());
   }
 };
 
+/* Evaluates the case with correctlyRoundedQuadric */
+template <typename fptype>
+class QuadExactTest : public NumericTester::NumericTest {
+ public:
+  QuadExactTest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
+  virtual std::string testName() {
+    return std::string(
+        "Correctly Rounded Quadric Evaluation");
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    const QuadricTestCase<fptype> *stCase =
+        dynamic_cast<const QuadricTestCase<fptype> *>(
+            &testCase);
+    assert(stCase != NULL);
+    startTimer();
+    fptype accumulator = correctlyRoundedQuadric(
+        stCase->pos, stCase->trans, stCase->radius);
+    stopTimer();
+    mpfr::mpreal estimate(accumulator);
+    if(signMode)
+      addSignStatistic(estimate, testCase.correctValue(),
+                       stCase->surfaceDistance());
+    else
+      addStatistic(estimate, testCase.correctValue());
+  }
+};
+
+/* Encloses the value computed like QuadFMATest in an
+ * interval, with the rounding mode switched outside of the
+ * timed region.
+ * The midpoint is added to the statistics, and the test
+ * reports the enclosure widths relative to the exact
+ * value, how often the sign is certified, and the cost
+ * relative to QuadFMATest's evaluation of the same case.
+ * In sign mode only certified signs are classified;
+ * enclosures which contain 0 and another value are
+ * counted as uncertain instead
+ */
+template <typename fptype>
+class QuadIntervalTest : public NumericTester::NumericTest {
+ public:
+  QuadIntervalTest(bool signMode = false)
+      : NumericTester::NumericTest(signMode),
+        certified(0),
+        uncertainSigns(0),
+        enclosureFailures(0),
+        cases(0),
+        accumWidth(0.0),
+        fmaTime({0, 0}) {}
+
+  virtual std::string testName() {
+    return std::string("Interval Quadric Evaluation");
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    const QuadricTestCase<fptype> *stCase =
+        dynamic_cast<const QuadricTestCase<fptype> *>(
+            &testCase);
+    assert(stCase != NULL);
+    using interval = Interval<fptype>;
+    interval accumulator;
+    {
+      UpwardRounding rounding;
+      startTimer();
+      interval moddedPt[stCase->dim];
+      interval radius(stCase->radius);
+      interval transSum = -(radius * radius);
+      for(unsigned i = 0; i < stCase->dim; i++) {
+        moddedPt[i] = interval(stCase->pos[i]) +
+                      interval(stCase->trans[i]);
+        transSum = interval::fmaPoint(
+            stCase->pos[i], stCase->trans[i], transSum);
+        transSum = interval::fmaPoint(
+            stCase->trans[i], stCase->trans[i], transSum);
+      }
+      accumulator = transSum;
+      for(unsigned i = 0; i < stCase->dim; i++) {
+        accumulator =
+            interval::fma(interval(stCase->pos[i]),
+                          moddedPt[i], accumulator);
+      }
+      stopTimer();
+    }
+    timeFMA(stCase);
+    const mpfr::mpreal correct = testCase.correctValue();
+    mpfr::mpreal lower(accumulator.lower());
+    mpfr::mpreal upper(accumulator.upper());
+    if(lower > correct || upper < correct)
+      enclosureFailures++;
+    const int sign = certifiedSign(accumulator);
+    if(sign != 0) certified++;
+    cases++;
+    if(correct != 0)
+      accumWidth += (upper - lower) / mpfr::abs(correct);
+    if(!signMode) {
+      addStatistic((lower + upper) / 2, correct);
+    } else if(sign == 0 && (lower != 0 || upper != 0)) {
+      uncertainSigns++;
+    } else {
+      addSignStatistic(mpfr::mpreal(sign), correct,
+                       stCase->surfaceDistance());
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    const struct timespec time = totalRunTime();
+    out << "Average Relative Enclosure Width: "
+        << accumWidth / cases << "\n"
+        << "Certified Signs: " << certified << " of "
+        << cases << "\n";
+    if(signMode)
+      out << "Uncertain Signs: " << uncertainSigns << "\n";
+    out << "Enclosure Failures: " << enclosureFailures
+        << "\n"
+        << "Cost Relative to FMA: "
+        << (time.tv_sec + time.tv_nsec * 1e-9) /
+               (fmaTime.tv_sec + fmaTime.tv_nsec * 1e-9)
+        << "x\n";
+  }
+
+ private:
+  void timeFMA(const QuadricTestCase<fptype> *stCase) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    fptype moddedPt[stCase->dim];
+    fptype transSum = -stCase->radius * stCase->radius;
+    for(unsigned i = 0; i < stCase->dim; i++) {
+      moddedPt[i] = stCase->pos[i] + stCase->trans[i];
+      transSum = std::fma(stCase->pos[i], stCase->trans[i],
+                          transSum);
+      transSum = std::fma(stCase->trans[i],
+                          stCase->trans[i], transSum);
+    }
+    volatile fptype accumulator = transSum;
+    for(unsigned i = 0; i < stCase->dim; i++) {
+      accumulator = std::fma(stCase->pos[i], moddedPt[i],
+                             accumulator);
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    fmaTime.tv_sec += end.tv_sec - start.tv_sec;
+    fmaTime.tv_nsec += end.tv_nsec - start.tv_nsec;
+  }
+
+  unsigned long certified;
+  unsigned long uncertainSigns;
+  unsigned long enclosureFailures;
+  unsigned long cases;
+  mpfr::mpreal accumWidth;
+  struct timespec fmaTime;
+};
+
 template <typename testtype, typename fptype>
 void runQuadricTests(
     std::mt19937_64 engine,
     std::uniform_real_distribution<fptype> rgenf,
-    const int n, const std::string testclass) {
+    const int n, const std::string testclass,
+    bool signMode = false) {
   NumericTester::NumericTest *tests[] = {
-      new QuadNullTest<fptype>(),
-      new QuadNaiveTest<fptype>(),
-      new QuadFMATest<fptype>(),
-      new QuadKahanFMATest<fptype>(),
-      new QuadNullTest<fptype>(),
-      new QuadNaiveTest<fptype>(),
-      new QuadFMATest<fptype>(),
-      new QuadKahanFMATest<fptype>()};
+      new QuadNullTest<fptype>(signMode),
+      new QuadNaiveTest<fptype>(signMode),
+      new QuadFMATest<fptype>(signMode),
+      new QuadKahanFMATest<fptype>(signMode),
+      new QuadExactTest<fptype>(signMode),
+      new QuadIntervalTest<fptype>(signMode),
+      new QuadNullTest<fptype>(signMode),
+      new QuadNaiveTest<fptype>(signMode),
+      new QuadFMATest<fptype>(signMode),
+      new QuadKahanFMATest<fptype>(signMode),
+      new QuadExactTest<fptype>(signMode),
+      new QuadIntervalTest<fptype>(signMode)};
   constexpr const int numTests =
       sizeof(tests) / sizeof(tests[0]);
   for(int i = 0; i < n; i++) {
@@ -239,21 +478,882 @@ void runQuadricTests(
   for(auto t : tests) delete t;
 }
 
+template <typename fptype>
+RayQuadric<fptype> rayQuadric(
+    const SphereTransCase<fptype> &shape) {
+  RayQuadric<fptype> quadric;
+  for(unsigned i = 0; i < shape.dim; i++) {
+    quadric.trans[i] = shape.trans[i];
+    quadric.weight[i] = 1.0;
+  }
+  quadric.radius = shape.radius;
+  return quadric;
+}
+
+template <typename fptype>
+RayQuadric<fptype> rayQuadric(
+    const AxisCylinderTransCase<fptype> &shape) {
+  RayQuadric<fptype> quadric;
+  for(unsigned i = 0; i < shape.dim; i++) {
+    quadric.trans[i] = shape.trans[i];
+    quadric.weight[i] = i == shape.axis ? 0.0 : 1.0;
+  }
+  quadric.radius = shape.radius;
+  return quadric;
+}
+
+/* Rays against the surface of a shape test case.
+ * Each ray passes its closest point to the surface's
+ * center (or axis) at radius * (1 +- 2^-k) from it,
+ * with k uniform up to the precision, so the hardest rays
+ * graze the surface.
+ * The origins start a few radii away, outside the surface.
+ * Every ray has an exact MPFR hit classification, from
+ * the sign of a discriminant computed without rounding,
+ * and an MPFR distance to the nearest hit
+ */
+template <typename fptype, typename shapetype>
+class RayQuadricCase : public NumericTester::TestCase {
+ public:
+  RayQuadricCase(
+      std::mt19937_64 &rgen,
+      std::uniform_real_distribution<fptype> &dist,
+      unsigned numRays)
+      : NumericTester::TestCase(),
+        shape(rgen, dist),
+        quadric(rayQuadric(shape)),
+        rays(numRays),
+        correctHit(numRays),
+        correctDist(numRays) {
+    constexpr const unsigned dim = RayQuadric<fptype>::dim;
+    constexpr const int precision =
+        GenericFP::fpconvert<fptype>::precision;
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::uniform_int_distribution<int> closeness(0,
+                                                 precision);
+    std::uniform_real_distribution<double> length(2.0, 8.0);
+    for(unsigned r = 0; r < numRays; r++) {
+      double dir[dim], projected[dim], other[dim];
+      double projNorm;
+      do {
+        projNorm = 0.0;
+        for(unsigned i = 0; i < dim; i++) {
+          dir[i] = unit(rgen);
+          projected[i] = dir[i] * quadric.weight[i];
+          projNorm += projected[i] * projected[i];
+          other[i] = quadric.weight[i] == 0.0 ? 1.0 : 0.0;
+        }
+        projNorm = std::sqrt(projNorm);
+      } while(projNorm < 1e-3);
+      if(std::count(other, other + dim, 1.0) == 0) {
+        for(unsigned i = 0; i < dim; i++)
+          other[i] = unit(rgen);
+      }
+      /* Perpendicular to the projected direction,
+       * and to the axis of a cylinder
+       */
+      double perp[dim], perpNorm = 0.0;
+      for(unsigned i = 0; i < dim; i++) {
+        perp[i] = projected[(i + 1) % dim] *
+                      other[(i + 2) % dim] -
+                  projected[(i + 2) % dim] *
+                      other[(i + 1) % dim];
+        perpNorm += perp[i] * perp[i];
+      }
+      perpNorm = std::sqrt(perpNorm);
+      const double sign = unit(rgen) < 0 ? -1.0 : 1.0;
+      const double offset =
+          quadric.radius *
+          (1.0 + sign * std::ldexp(1.0, -closeness(rgen)));
+      const double travel =
+          quadric.radius * length(rgen) / projNorm;
+      for(unsigned i = 0; i < dim; i++) {
+        const double target = -quadric.trans[i] +
+                              perp[i] / perpNorm * offset;
+        rays.origin[i][r] = target - dir[i] * travel;
+        rays.dir[i][r] = dir[i];
+      }
+    }
+    for(unsigned r = 0; r < numRays; r++) {
+      beginExactReference();
+      mpfr::mpreal a(0.0), h(0.0);
+      mpfr::mpreal c(quadric.radius);
+      c *= -c;
+      for(unsigned i = 0; i < dim; i++) {
+        if(quadric.weight[i] == 0.0) continue;
+        mpfr::mpreal d(rays.dir[i][r]);
+        mpfr::mpreal oc(rays.origin[i][r]);
+        oc += quadric.trans[i];
+        a += d * d;
+        h += d * oc;
+        c += oc * oc;
+      }
+      mpfr::mpreal disc = h * h - a * c;
+      endExactReference();
+      /* The case's value is the first ray's discriminant,
+       * whose sign classifies it; the tests use the
+       * classifications and distances of every ray
+       */
+      if(r == 0) correct = disc;
+      correctHit[r] = false;
+      if(disc < 0) continue;
+      mpfr::mpreal sqrtDisc = mpfr::sqrt(disc);
+      mpfr::mpreal tNear = (-h - sqrtDisc) / a;
+      mpfr::mpreal tFar = (-h + sqrtDisc) / a;
+      if(tFar <= 0) continue;
+      correctHit[r] = true;
+      correctDist[r] = tNear > 0 ? tNear : tFar;
+    }
+  }
+
+  /* The least precision which holds the discriminant of
+   * every ray exactly, for shapes with coordinates and
+   * radius of magnitude at most maxMag.
+   * Origins are at most 8 radii over a projected direction
+   * of at least 2^-10 from a target within 3 maxMag, so
+   * their offsets from the center are below 2^15 maxMag,
+   * and directions are below 1.
+   * h^2 - a c is a sum of 21 products of 4 of these
+   */
+  static mpfr_prec_t referencePrecision(fptype maxMag) {
+    return NumericTester::exactPrecision(
+        NumericTester::ulpExponent<fptype>(
+            std::numeric_limits<fptype>::min_exponent),
+        std::ilogb(maxMag) + 16, 4, 21);
+  }
+
+  const shapetype shape;
+  const RayQuadric<fptype> quadric;
+  RayPacket<fptype> rays;
+  std::vector<bool> correctHit;
+  std::vector<mpfr::mpreal> correctDist;
+};
+
+/* Distances of rays which are classified correctly as
+ * hits are added to the statistics.
+ * Throughput is reported as millions of rays per second
+ */
+template <typename fptype, typename shapetype,
+          typename kernel>
+class RayQuadricTest : public NumericTester::NumericTest {
+ public:
+  RayQuadricTest()
+      : NumericTester::NumericTest(),
+        hitAsMiss(0),
+        missAsHit(0),
+        numRays(0.0),
+        dist() {}
+
+  virtual std::string testName() {
+    return std::string(kernel::name) +
+           " Ray Intersection with " +
+           GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const RayQuadricCase<fptype, shapetype>));
+    const RayQuadricCase<fptype, shapetype> *rayCase =
+        static_cast<
+            const RayQuadricCase<fptype, shapetype> *>(
+            &testCase);
+    const unsigned size = rayCase->rays.size();
+    dist.resize(size);
+    startTimer();
+    intersectRays<kernel>(rayCase->quadric, rayCase->rays,
+                          dist.data());
+    stopTimer();
+    numRays += size;
+    for(unsigned r = 0; r < size; r++) {
+      const bool hit = !std::isinf(dist[r]);
+      if(hit != rayCase->correctHit[r]) {
+        if(hit)
+          missAsHit++;
+        else
+          hitAsMiss++;
+        continue;
+      }
+      if(!hit) continue;
+      mpfr::mpreal estimate(dist[r]);
+      addStatistic(estimate, rayCase->correctDist[r]);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Hits Classified as Misses: " << hitAsMiss
+        << "\n"
+        << "Misses Classified as Hits: " << missAsHit
+        << "\n"
+        << "Million Rays/s: " << numRays / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  unsigned long hitAsMiss;
+  unsigned long missAsHit;
+  double numRays;
+  std::vector<fptype> dist;
+};
+
+template <typename shapetype, typename fptype>
+void runRayTests(
+    std::mt19937_64 &engine,
+    std::uniform_real_distribution<fptype> rgenf,
+    const int n, const unsigned numRays,
+    const std::string testclass) {
+  NumericTester::NumericTest *tests[] = {
+      new RayQuadricTest<fptype, shapetype,
+                         NaiveRayKernel>(),
+      new RayQuadricTest<fptype, shapetype, FMARayKernel>(),
+      new RayQuadricTest<fptype, shapetype,
+                         CompensatedRayKernel>()};
+  for(int i = 0; i < n; i++) {
+    RayQuadricCase<fptype, shapetype> testcase(
+        engine, rgenf, numRays);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  std::cout << testclass << "\n\n";
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n";
+    std::string fname =
+        t->testName().append(" ").append(testclass).append(
+            ".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+/* A general quadric: a random diagonal quadric, with
+ * entries of -1, 0, or 1 and a constant of -radius^2,
+ * composed with a random affine transform, so
+ *   Q(p) = D(A p + t)
+ * The transformed coefficients are computed with MPFR and
+ * then rounded.
+ * Half of the points are uniform, and the rest are the
+ * preimages of random points on the diagonal quadric,
+ * where the value nearly cancels and its sign classifies
+ * the point.
+ * Every point has an exact MPFR reference for the rounded
+ * coefficients
+ */
+template <typename fptype>
+class GeneralQuadricCase : public NumericTester::TestCase {
+ public:
+  static constexpr const unsigned dim = 3;
+
+  GeneralQuadricCase(
+      std::mt19937_64 &rgen,
+      std::uniform_real_distribution<fptype> &dist,
+      unsigned numPoints)
+      : NumericTester::TestCase(),
+        quadric(),
+        correctValues(numPoints),
+        precision(0) {
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::uniform_int_distribution<int> sign(-1, 1);
+    int diag[dim];
+    do {
+      for(unsigned i = 0; i < dim; i++)
+        diag[i] = sign(rgen);
+    } while(diag[0] == 0 && diag[1] == 0 && diag[2] == 0);
+    const double radius = std::fabs(dist(rgen));
+    double affine[dim][dim], trans[dim];
+    for(unsigned i = 0; i < dim; i++) {
+      for(unsigned j = 0; j < dim; j++)
+        affine[i][j] = unit(rgen);
+      trans[i] = dist(rgen);
+    }
+    /* The homogeneous transform H = [A t; 0 1],
+     * so the matrix is H^T D H
+     */
+    mpfr::mpreal homogeneous[dim + 1][dim + 1];
+    for(unsigned i = 0; i <= dim; i++) {
+      for(unsigned j = 0; j <= dim; j++) {
+        if(i == dim)
+          homogeneous[i][j] = j == dim ? 1.0 : 0.0;
+        else
+          homogeneous[i][j] =
+              j == dim ? trans[i] : affine[i][j];
+      }
+    }
+    mpfr::mpreal diagonal[dim + 1] = {
+        diag[0], diag[1], diag[2], -radius * radius};
+    mpfr::mpreal matrix[dim + 1][dim + 1];
+    for(unsigned i = 0; i <= dim; i++) {
+      for(unsigned j = 0; j <= dim; j++) {
+        matrix[i][j] = 0.0;
+        for(unsigned k = 0; k <= dim; k++)
+          matrix[i][j] += homogeneous[k][i] * diagonal[k] *
+                          homogeneous[k][j];
+      }
+    }
+    quadric = GeneralQuadric<fptype>::fromMatrix(matrix);
+    for(unsigned i = 0; i < dim; i++)
+      points[i].resize(numPoints);
+    double inverse[dim][dim];
+    invert(affine, inverse);
+    for(unsigned p = 0; p < numPoints; p++) {
+      double onSurface[dim], scale = 0.0;
+      for(unsigned i = 0; i < dim; i++) {
+        onSurface[i] = unit(rgen);
+        scale += diag[i] * onSurface[i] * onSurface[i];
+      }
+      for(unsigned i = 0; i < dim; i++) {
+        if(p % 2 == 0 || scale <= 0.0) {
+          points[i][p] = dist(rgen);
+          continue;
+        }
+        /* A^-1 (u - t) for u on the diagonal quadric */
+        double preimage = 0.0;
+        for(unsigned j = 0; j < dim; j++) {
+          const double u =
+              onSurface[j] * radius / std::sqrt(scale);
+          preimage += inverse[i][j] * (u - trans[j]);
+        }
+        points[i][p] = preimage;
+      }
+    }
+    precision = referencePrecision();
+    beginExactReference();
+    for(unsigned p = 0; p < numPoints; p++) {
+      const mpfr::mpreal pt[dim + 1] = {
+          mpfr::mpreal(points[0][p], precision),
+          mpfr::mpreal(points[1][p], precision),
+          mpfr::mpreal(points[2][p], precision),
+          mpfr::mpreal(1.0, precision)};
+      mpfr::mpreal value(0.0, precision);
+      for(unsigned i = 0; i <= dim; i++) {
+        for(unsigned j = i; j <= dim; j++) {
+          const fptype coeff =
+              quadric.coeffs[coeffIndex(i, j)];
+          value += pt[i] * coeff * pt[j];
+        }
+      }
+      correctValues[p] = value;
+    }
+    endExactReference();
+    correct = correctValues[0];
+  }
+
+  unsigned size() const { return correctValues.size(); }
+
+  /* Sets grad to the exact gradient at the p-th point */
+  void correctGradient(unsigned p,
+                       mpfr::mpreal (&grad)[dim]) const {
+    beginExactReference();
+    for(unsigned i = 0; i < dim; i++) {
+      const std::array<fptype, 4> row =
+          quadric.gradientRow(i);
+      grad[i].set_prec(precision);
+      grad[i] = row[3];
+      for(unsigned j = 0; j < dim; j++) {
+        mpfr::mpreal term(row[j], precision);
+        term *= points[j][p];
+        grad[i] += term;
+      }
+    }
+    endExactReference();
+  }
+
+  GeneralQuadric<fptype> quadric;
+  std::vector<fptype> points[dim];
+  std::vector<mpfr::mpreal> correctValues;
+
+ private:
+  /* The least precision which holds the values and the
+   * gradients at the points exactly, from the exponents
+   * of the rounded coefficients and the points, as the
+   * preimages are unbounded when the transform is nearly
+   * singular.
+   * A value sums 10 products of a coefficient and two
+   * coordinates or 1; the gradient's products only have 2
+   * factors, which covers its coefficients being doubled
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    auto include = [&](fptype val) {
+      if(val == 0 || !std::isfinite(val)) return;
+      const int exp = std::ilogb(val) + 1;
+      ulpExp = std::min(
+          ulpExp, NumericTester::ulpExponent<fptype>(exp));
+      maxExp = std::max<long>(maxExp, exp);
+    };
+    for(fptype coeff : quadric.coeffs) include(coeff);
+    for(unsigned i = 0; i < dim; i++) {
+      for(fptype coord : points[i]) include(coord);
+    }
+    return NumericTester::exactPrecision(ulpExp, maxExp, 3,
+                                         10);
+  }
+
+  mpfr_prec_t precision;
+
+  /* The coefficient of entry (i, j) of the matrix */
+  static unsigned coeffIndex(unsigned i, unsigned j) {
+    using Q = GeneralQuadric<fptype>;
+    const unsigned index[dim + 1][dim + 1] = {
+        {Q::xx, Q::xy, Q::xz, Q::x},
+        {Q::xy, Q::yy, Q::yz, Q::y},
+        {Q::xz, Q::yz, Q::zz, Q::z},
+        {Q::x, Q::y, Q::z, Q::one}};
+    return index[i][j];
+  }
+
+  static void invert(const double (&m)[dim][dim],
+                     double (&inv)[dim][dim]) {
+    double det = 0.0;
+    for(unsigned i = 0; i < dim; i++) {
+      for(unsigned j = 0; j < dim; j++) {
+        /* The cofactor of m[j][i] */
+        inv[i][j] = m[(j + 1) % dim][(i + 1) % dim] *
+                        m[(j + 2) % dim][(i + 2) % dim] -
+                    m[(j + 1) % dim][(i + 2) % dim] *
+                        m[(j + 2) % dim][(i + 1) % dim];
+      }
+      det += m[0][i] * inv[i][0];
+    }
+    for(unsigned i = 0; i < dim; i++) {
+      for(unsigned j = 0; j < dim; j++) inv[i][j] /= det;
+    }
+  }
+};
+
+/* Points whose exact value is 0 have no relative error,
+ * so they are left out of the statistics.
+ * A point is misclassified when the sign of its value is
+ * wrong, which includes values rounded to 0.
+ * Throughput is reported as millions of points per second
+ */
+template <typename fptype, typename kernel>
+class GeneralQuadricTest
+    : public NumericTester::NumericTest {
+ public:
+  GeneralQuadricTest()
+      : NumericTester::NumericTest(),
+        signErrors(0),
+        numPoints(0.0),
+        values() {}
+
+  virtual std::string testName() {
+    return std::string(kernel::name) +
+           " General Quadric Evaluation with " +
+           GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const GeneralQuadricCase<fptype>));
+    const GeneralQuadricCase<fptype> *qCase =
+        static_cast<const GeneralQuadricCase<fptype> *>(
+            &testCase);
+    const unsigned size = qCase->size();
+    values.resize(size);
+    startTimer();
+    evaluateQuadric<kernel>(
+        qCase->quadric, qCase->points[0].data(),
+        qCase->points[1].data(), qCase->points[2].data(),
+        values.data(), size);
+    stopTimer();
+    numPoints += size;
+    for(unsigned p = 0; p < size; p++) {
+      const mpfr::mpreal &correct = qCase->correctValues[p];
+      if(mpfr::sgn(correct) != (values[p] > 0) -
+                                   (values[p] < 0))
+        signErrors++;
+      if(correct == 0) continue;
+      mpfr::mpreal estimate(values[p]);
+      addStatistic(estimate, correct);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Misclassified Points: " << signErrors << "\n"
+        << "Million Points/s: " << numPoints / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  unsigned long signErrors;
+  double numPoints;
+  std::vector<fptype> values;
+};
+
+template <typename fptype>
+void runGeneralQuadricTests(std::mt19937_64 &engine,
+                            const fptype maxMag,
+                            const int n,
+                            const unsigned numPoints) {
+  NumericTester::NumericTest *tests[] = {
+      new GeneralQuadricTest<fptype, NaiveQuadricKernel>(),
+      new GeneralQuadricTest<fptype, FMAQuadricKernel>(),
+      new GeneralQuadricTest<fptype,
+                             KahanFMAQuadricKernel>(),
+      new GeneralQuadricTest<fptype, ExactQuadricKernel>()};
+  std::uniform_real_distribution<fptype> rgenf(-maxMag,
+                                               maxMag);
+  for(int i = 0; i < n; i++) {
+    GeneralQuadricCase<fptype> testcase(engine, rgenf,
+                                        numPoints);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+/* Normals are compared with the normalized MPFR gradient
+ * by the angle between them, which is added to the
+ * statistics as the error of 1 + angle, so the relative
+ * error statistics are of the angle in radians.
+ * Points where either gradient is 0 have no normal, and are
+ * only counted
+ */
+template <typename fptype, typename kernel>
+class QuadricNormalTest
+    : public NumericTester::NumericTest {
+ public:
+  QuadricNormalTest()
+      : NumericTester::NumericTest(),
+        degenerate(0),
+        numPoints(0.0),
+        normals() {}
+
+  virtual std::string testName() {
+    return std::string(kernel::name) +
+           " Quadric Normals with " +
+           GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const GeneralQuadricCase<fptype>));
+    const GeneralQuadricCase<fptype> *qCase =
+        static_cast<const GeneralQuadricCase<fptype> *>(
+            &testCase);
+    constexpr const unsigned dim =
+        GeneralQuadricCase<fptype>::dim;
+    const unsigned size = qCase->size();
+    for(unsigned i = 0; i < dim; i++)
+      normals[i].resize(size);
+    startTimer();
+    quadricNormals<kernel>(
+        qCase->quadric, qCase->points[0].data(),
+        qCase->points[1].data(), qCase->points[2].data(),
+        normals[0].data(), normals[1].data(),
+        normals[2].data(), size);
+    stopTimer();
+    numPoints += size;
+    for(unsigned p = 0; p < size; p++) {
+      mpfr::mpreal correct[dim], computed[dim];
+      mpfr::mpreal dot(0.0), cross(0.0), length(0.0);
+      qCase->correctGradient(p, correct);
+      for(unsigned i = 0; i < dim; i++) {
+        computed[i] = normals[i][p];
+        length += correct[i] * correct[i];
+      }
+      if(length == 0 || !std::isfinite(normals[0][p])) {
+        degenerate++;
+        continue;
+      }
+      for(unsigned i = 0; i < dim; i++) {
+        dot += computed[i] * correct[i];
+        const unsigned j = (i + 1) % dim, k = (i + 2) % dim;
+        const mpfr::mpreal c = computed[j] * correct[k] -
+                               computed[k] * correct[j];
+        cross += c * c;
+      }
+      const mpfr::mpreal angle =
+          mpfr::atan2(mpfr::sqrt(cross), dot);
+      addStatistic(1 + angle, mpfr::mpreal(1.0));
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Degenerate Normals: " << degenerate << "\n"
+        << "Million Points/s: " << numPoints / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  unsigned long degenerate;
+  double numPoints;
+  std::vector<fptype> normals[3];
+};
+
+template <typename fptype>
+void runQuadricNormalTests(std::mt19937_64 &engine,
+                           const fptype maxMag,
+                           const int n,
+                           const unsigned numPoints) {
+  NumericTester::NumericTest *tests[] = {
+      new QuadricNormalTest<fptype, NaiveGradientKernel>(),
+      new QuadricNormalTest<fptype, FMAGradientKernel>(),
+      new QuadricNormalTest<fptype,
+                            CompensatedGradientKernel>()};
+  std::uniform_real_distribution<fptype> rgenf(-maxMag,
+                                               maxMag);
+  for(int i = 0; i < n; i++) {
+    GeneralQuadricCase<fptype> testcase(engine, rgenf,
+                                        numPoints);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+/* A block of cases generated like testtype, stored as a
+ * structure of arrays for the batched kernels
+ */
+template <typename fptype, typename testtype>
+class QuadricBatchCase : public NumericTester::TestCase {
+ public:
+  QuadricBatchCase(
+      std::mt19937_64 &rgen,
+      std::uniform_real_distribution<fptype> &dist,
+      unsigned batchSize)
+      : NumericTester::TestCase(),
+        batch(batchSize),
+        correctValues(batchSize) {
+    for(unsigned c = 0; c < batchSize; c++) {
+      testtype qCase(rgen, dist);
+      for(unsigned i = 0; i < qCase.dim; i++) {
+        batch.pos[i][c] = qCase.pos[i];
+        batch.trans[i][c] = qCase.trans[i];
+      }
+      batch.radius[c] = qCase.radius;
+      correctValues[c] = qCase.correctValue();
+    }
+    correct = correctValues[0];
+  }
+
+  unsigned size() const { return batch.size(); }
+
+  /* Every case checks its own reference is exact */
+  static mpfr_prec_t referencePrecision(fptype maxMag) {
+    return testtype::referencePrecision(maxMag);
+  }
+
+  QuadricBatch<fptype> batch;
+  std::vector<mpfr::mpreal> correctValues;
+};
+
+/* Only the batched evaluation is timed, and every case's
+ * result is added to the statistics, so the accuracy is
+ * comparable with the scalar tests
+ */
+template <typename fptype, typename testtype,
+          typename kernel>
+class QuadBatchTest : public NumericTester::NumericTest {
+ public:
+  QuadBatchTest()
+      : NumericTester::NumericTest(),
+        numCases(0.0),
+        values() {}
+
+  virtual std::string testName() {
+    return std::string(kernel::name) +
+           " Batched Quadric Evaluation";
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    using casetype = QuadricBatchCase<fptype, testtype>;
+    assert(typeid(testCase) == typeid(const casetype));
+    const casetype *bCase =
+        static_cast<const casetype *>(&testCase);
+    const unsigned size = bCase->size();
+    values.resize(size);
+    startTimer();
+    evaluateQuadrics<kernel>(bCase->batch, values.data());
+    stopTimer();
+    numCases += size;
+    for(unsigned c = 0; c < size; c++) {
+      mpfr::mpreal estimate(values[c]);
+      addStatistic(estimate, bCase->correctValues[c]);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Million Points/s: " << numCases / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  double numCases;
+  std::vector<fptype> values;
+};
+
+template <typename testtype, typename fptype>
+void runQuadricBatchTests(
+    std::mt19937_64 &engine,
+    std::uniform_real_distribution<fptype> &rgenf,
+    const int n, const unsigned batchSize,
+    std::string testclass) {
+  NumericTester::NumericTest *tests[] = {
+      new QuadBatchTest<fptype, testtype,
+                        NaiveBatchKernel>(),
+      new QuadBatchTest<fptype, testtype,
+                        FMABatchKernel>(),
+      new QuadBatchTest<fptype, testtype,
+                        KahanFMABatchKernel>()};
+  for(int i = 0; i < n; i++) {
+    QuadricBatchCase<fptype, testtype> testcase(
+        engine, rgenf, batchSize);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  std::cout << testclass << "\n\n";
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n";
+    std::string fname =
+        t->testName().append(" ").append(testclass).append(
+            ".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
 int main(int argc, char **argv) {
-  mpfr::mpreal::set_default_prec(128);
   using fptype = float;
   constexpr const fptype maxMag = 1024.0 * 1024.0;
+  mpfr::mpreal::set_default_prec(
+      QuadricTestCase<fptype>::referencePrecision(maxMag));
   constexpr const unsigned numTests = 5e6;
   std::random_device rd;
   std::mt19937_64 engine(rd());
   std::uniform_real_distribution<fptype> rgenf(-maxMag,
                                                maxMag);
+  /* quadtest rays [numTests] [numRays] intersects packets
+   * of rays with the shapes instead
+   */
+  if(argc > 1 && std::strcmp(argv[1], "rays") == 0) {
+    int numRayTests = 1024;
+    int numRays = 1024;
+    if(argc > 2) numRayTests = atoi(argv[2]);
+    if(argc > 3) numRays = atoi(argv[3]);
+    if(numRayTests < 1 || numRays < 1) {
+      printf("Number of tests and rays must be greater "
+             "than 0\n");
+      return -1;
+    }
+    mpfr::mpreal::set_default_prec(
+        RayQuadricCase<fptype, SphereTransCase<fptype>>::
+            referencePrecision(maxMag));
+    runRayTests<SphereTransCase<fptype>>(
+        engine, rgenf, numRayTests, numRays,
+        std::string("Sphere Ray Tests"));
+    std::cout << "\n\n";
+    runRayTests<AxisCylinderTransCase<fptype>>(
+        engine, rgenf, numRayTests, numRays,
+        std::string("Axis Aligned Cylinder Ray Tests"));
+    return 0;
+  }
+  /* quadtest batch [numTests] [batchSize] evaluates
+   * blocks of cases with the vectorized kernels
+   */
+  if(argc > 1 && std::strcmp(argv[1], "batch") == 0) {
+    int numBatchTests = 1024;
+    int batchSize = 4096;
+    if(argc > 2) numBatchTests = atoi(argv[2]);
+    if(argc > 3) batchSize = atoi(argv[3]);
+    if(numBatchTests < 1 || batchSize < 1) {
+      printf("Number of tests and batch size must be "
+             "greater than 0\n");
+      return -1;
+    }
+    mpfr::mpreal::set_default_prec(
+        QuadricBatchCase<fptype, SphereTransCase<fptype>>::
+            referencePrecision(maxMag));
+    runQuadricBatchTests<SphereTransCase<fptype>>(
+        engine, rgenf, numBatchTests, batchSize,
+        std::string("Sphere Batch Tests"));
+    std::cout << "\n\n";
+    runQuadricBatchTests<AxisCylinderTransCase<fptype>>(
+        engine, rgenf, numBatchTests, batchSize,
+        std::string("Axis Aligned Cylinder Batch Tests"));
+    return 0;
+  }
+  /* quadtest general [numTests] [numPoints] evaluates
+   * transformed general quadrics in both precisions, and
+   * quadtest normals computes their unit normals
+   */
+  const bool general =
+      argc > 1 && std::strcmp(argv[1], "general") == 0;
+  const bool normals =
+      argc > 1 && std::strcmp(argv[1], "normals") == 0;
+  if(general || normals) {
+    int numGeneralTests = 256;
+    int numPoints = 4096;
+    if(argc > 2) numGeneralTests = atoi(argv[2]);
+    if(argc > 3) numPoints = atoi(argv[3]);
+    if(numGeneralTests < 1 || numPoints < 1) {
+      printf("Number of tests and points must be greater "
+             "than 0\n");
+      return -1;
+    }
+    /* The cases set the precision of their references
+     * from their coefficients and points
+     */
+    if(normals) {
+      runQuadricNormalTests<float>(
+          engine, maxMag, numGeneralTests, numPoints);
+      std::cout << "\n\n";
+      runQuadricNormalTests<double>(
+          engine, maxMag, numGeneralTests, numPoints);
+      return 0;
+    }
+    runGeneralQuadricTests<float>(
+        engine, maxMag, numGeneralTests, numPoints);
+    std::cout << "\n\n";
+    runGeneralQuadricTests<double>(
+        engine, maxMag, numGeneralTests, numPoints);
+    return 0;
+  }
+  /* quadtest signs only checks the signs of the values,
+   * as an inside or outside test
+   */
+  const bool signMode =
+      argc > 1 && std::strcmp(argv[1], "signs") == 0;
+  const std::string suffix =
+      signMode ? " Sign Tests" : " Tests";
   runQuadricTests<SphereTransCase<fptype>, fptype>(
-      engine, rgenf, numTests, std::string("Sphere Tests"));
+      engine, rgenf, numTests,
+      std::string("Sphere").append(suffix), signMode);
 	std::cout.flush();
   std::cout << "\n\n";
   runQuadricTests<AxisCylinderTransCase<fptype>, fptype>(
       engine, rgenf, numTests,
-      std::string("Axis Aligned Cylinder Tests"));
+      std::string("Axis Aligned Cylinder").append(suffix),
+      signMode);
   return 0;
 }
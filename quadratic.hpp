@@ -0,0 +1,147 @@
+
+#ifndef _QUADRATIC_HPP_
+#define _QUADRATIC_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "accurate_math.hpp"
+#include "simd.hpp"
+
+/* Solvers for the roots of a t^2 + b t + c, with a != 0.
+ * Each solver works on a vector of coefficient sets, with
+ * a set per lane, and writes the discriminant, whose sign
+ * classifies the roots as real or complex, and the real
+ * roots in increasing order.
+ * The roots of lanes with a negative discriminant are NaN
+ */
+
+template <typename vec>
+void orderRoots(vec r1, vec r2, vec &low, vec &high) {
+  low = r1 < r2 ? r1 : r2;
+  high = r1 < r2 ? r2 : r1;
+}
+
+/* Computes the root of larger magnitude with the square
+ * root of the discriminant added to |b|, so there is no
+ * cancellation, and the other root from their product,
+ * c / a.
+ * The square root is sqrtHi + sqrtLo
+ */
+template <typename fptype, typename vec>
+void stableRoots(vec a, vec b, vec c, vec sqrtHi,
+                 vec sqrtLo, vec &low, vec &high) {
+  const vec sqrtDisc = b < 0 ? -sqrtHi : sqrtHi;
+  const vec sqrtDiscLo = b < 0 ? -sqrtLo : sqrtLo;
+  const vec q =
+      fptype(-0.5) * ((b + sqrtDisc) + sqrtDiscLo);
+  orderRoots<vec>(q / a, c / q, low, high);
+}
+
+struct NaiveQuadratic {
+  static constexpr const char *name = "Naive";
+  template <typename fptype, typename vec>
+  static void solve(vec a, vec b, vec c, vec &disc,
+                    vec &low, vec &high) {
+    disc = b * b - fptype(4.0) * a * c;
+    const vec sqrtDisc = SIMD::sqrt<fptype>(disc);
+    const vec denom = fptype(2.0) * a;
+    orderRoots<vec>((-b - sqrtDisc) / denom,
+                    (-b + sqrtDisc) / denom, low, high);
+  }
+};
+
+struct StableQuadratic {
+  static constexpr const char *name = "Stable";
+  template <typename fptype, typename vec>
+  static void solve(vec a, vec b, vec c, vec &disc,
+                    vec &low, vec &high) {
+    disc = b * b - fptype(4.0) * a * c;
+    stableRoots<fptype>(a, b, c, SIMD::sqrt<fptype>(disc),
+                        vec{}, low, high);
+  }
+};
+
+/* Kahan's discriminant: when b^2 and 4 a c nearly cancel,
+ * the rounding errors of both products are recovered with
+ * an FMA and added back.
+ * Kahan's test only takes the slower path when the
+ * difference has lost bits to cancellation; here both are
+ * computed, and the test selects between them per lane
+ */
+struct KahanQuadratic {
+  static constexpr const char *name = "Kahan FMA";
+  template <typename fptype, typename vec>
+  static void solve(vec a, vec b, vec c, vec &disc,
+                    vec &low, vec &high) {
+    const vec a4 = fptype(4.0) * a;
+    const vec p = b * b;
+    const vec q = a4 * c;
+    const vec d = p - q;
+    const vec pErr = SIMD::fma<fptype>(b, b, -p);
+    const vec qErr = SIMD::fma<fptype>(a4, c, -q);
+    const vec absD = d < 0 ? -d : d;
+    disc = fptype(3.0) * absD >= p + q
+               ? d
+               : (p - q) + (pErr - qErr);
+    stableRoots<fptype>(a, b, c, SIMD::sqrt<fptype>(disc),
+                        vec{}, low, high);
+  }
+};
+
+/* The discriminant is formed as a double-double (or
+ * float-float) from the exact products, so its sign is
+ * always right unless the low parts' sum underflows, and
+ * the square root is refined with one Newton step for the
+ * low part
+ */
+struct DoubleDoubleQuadratic {
+  static constexpr const char *name = "Double-Double";
+  template <typename fptype, typename vec>
+  static void solve(vec a, vec b, vec c, vec &disc,
+                    vec &low, vec &high) {
+    const vec a4 = fptype(4.0) * a;
+    const vec p = b * b;
+    const vec q = a4 * c;
+    const vec pErr = SIMD::fma<fptype>(b, b, -p);
+    const vec qErr = SIMD::fma<fptype>(a4, c, -q);
+    std::array<vec, 2> diff = twoSumBranchFree(p, -q);
+    std::array<vec, 2> dd = twoSumBranchFree(
+        diff[0], diff[1] + (pErr - qErr));
+    disc = dd[0];
+    const vec sqrtHi = SIMD::sqrt<fptype>(dd[0]);
+    const vec residual =
+        SIMD::fma<fptype>(-sqrtHi, sqrtHi, dd[0]) + dd[1];
+    const vec sqrtLo =
+        dd[0] > 0 ? residual / (fptype(2.0) * sqrtHi)
+                  : vec{};
+    stableRoots<fptype>(a, b, c, sqrtHi, sqrtLo, low, high);
+  }
+};
+
+/* Solves count quadratics, with the coefficients of set i
+ * in a[i], b[i], and c[i]
+ */
+template <typename solver, typename fptype>
+void solveQuadratics(const fptype *a, const fptype *b,
+                     const fptype *c, fptype *disc,
+                     fptype *low, fptype *high,
+                     unsigned count) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  for(unsigned i = 0; i < count; i += lanes) {
+    const unsigned width = std::min(lanes, count - i);
+    vec d, l, h;
+    solver::template solve<fptype>(
+        SIMD::loadPartial(a + i, width),
+        SIMD::loadPartial(b + i, width),
+        SIMD::loadPartial(c + i, width), d, l, h);
+    SIMD::storePartial(disc + i, d, width);
+    SIMD::storePartial(low + i, l, width);
+    SIMD::storePartial(high + i, h, width);
+  }
+}
+
+#endif
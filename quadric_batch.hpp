@@ -0,0 +1,171 @@
+
+#ifndef _QUADRIC_BATCH_HPP_
+#define _QUADRIC_BATCH_HPP_
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "simd.hpp"
+
+/* Evaluation of a batch of translated spheres and axis
+ * aligned cylinders, each at its own point, as
+ *   sum_i pos[i] (pos[i] + trans[i])
+ *     + pos[i] trans[i] + trans[i]^2 - radius^2.
+ * The batch is stored as an array per coordinate, so the
+ * kernels evaluate a case per lane with the same operations
+ * as the scalar quadric tests
+ */
+
+template <typename fptype>
+struct QuadricBatch {
+  static constexpr const unsigned dim = 3;
+  QuadricBatch(unsigned size) : radius(size) {
+    for(unsigned i = 0; i < dim; i++) {
+      pos[i].resize(size);
+      trans[i].resize(size);
+    }
+  }
+
+  unsigned size() const { return radius.size(); }
+
+  std::vector<fptype> pos[dim];
+  std::vector<fptype> trans[dim];
+  std::vector<fptype> radius;
+};
+
+struct NaiveBatchKernel {
+  static constexpr const char *name = "Naive";
+  template <typename fptype, typename vec>
+  static vec evaluate(const vec (&pos)[3],
+                      const vec (&trans)[3], vec radius) {
+    vec moddedPt[3];
+    vec transSum = -radius * radius;
+    for(unsigned i = 0; i < 3; i++) {
+      moddedPt[i] = pos[i] + trans[i];
+      transSum += pos[i] * trans[i] + trans[i] * trans[i];
+    }
+    vec accumulator = transSum;
+    for(unsigned i = 0; i < 3; i++)
+      accumulator += pos[i] * moddedPt[i];
+    return accumulator;
+  }
+};
+
+struct FMABatchKernel {
+  static constexpr const char *name = "FMA";
+  template <typename fptype, typename vec>
+  static vec evaluate(const vec (&pos)[3],
+                      const vec (&trans)[3], vec radius) {
+    vec moddedPt[3];
+    vec transSum = -radius * radius;
+    for(unsigned i = 0; i < 3; i++) {
+      moddedPt[i] = pos[i] + trans[i];
+      transSum =
+          SIMD::fma<fptype>(pos[i], trans[i], transSum);
+      transSum =
+          SIMD::fma<fptype>(trans[i], trans[i], transSum);
+    }
+    vec accumulator = transSum;
+    for(unsigned i = 0; i < 3; i++)
+      accumulator = SIMD::fma<fptype>(pos[i], moddedPt[i],
+                                      accumulator);
+    return accumulator;
+  }
+};
+
+/* Kahan compensates the sum of the translation terms,
+ * as in QuadKahanFMATest
+ */
+struct KahanFMABatchKernel {
+  static constexpr const char *name = "Kahan FMA";
+  template <typename fptype, typename vec>
+  static vec evaluate(const vec (&pos)[3],
+                      const vec (&trans)[3], vec radius) {
+    vec moddedPt[3];
+    vec transSum = -radius * radius;
+    vec c1 = {}, c2 = {};
+    for(unsigned i = 0; i < 3; i++) {
+      moddedPt[i] = pos[i] + trans[i];
+      const vec mod1 =
+          SIMD::fma<fptype>(pos[i], trans[i], -c1);
+      vec tmp = transSum + mod1;
+      c1 = (tmp - transSum) - mod1;
+      transSum = tmp;
+      const vec mod2 =
+          SIMD::fma<fptype>(trans[i], trans[i], -c2);
+      tmp = transSum + mod2;
+      c2 = (tmp - transSum) - mod2;
+      transSum = tmp;
+    }
+    vec accumulator = transSum;
+    for(unsigned i = 0; i < 3; i++)
+      accumulator = SIMD::fma<fptype>(pos[i], moddedPt[i],
+                                      accumulator);
+    return accumulator;
+  }
+};
+
+/* Writes the value of every case in the batch */
+template <typename kernel, typename fptype>
+void evaluateQuadrics(const QuadricBatch<fptype> &batch,
+                      fptype *values) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  const unsigned count = batch.size();
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    vec pos[3], trans[3];
+    for(unsigned i = 0; i < 3; i++) {
+      pos[i] =
+          SIMD::loadPartial(batch.pos[i].data() + j, width);
+      trans[i] = SIMD::loadPartial(
+          batch.trans[i].data() + j, width);
+    }
+    const vec radius =
+        SIMD::loadPartial(batch.radius.data() + j, width);
+    const vec value = kernel::template evaluate<fptype>(
+        pos, trans, radius);
+    SIMD::storePartial(values + j, value, width);
+  }
+}
+
+/* The value of a single case, correctly rounded.
+ * (pos + trans)^2 - radius^2 is expanded into error free
+ * terms: twoSum splits every translated coordinate into
+ * s + e, and the products s^2, 2 s e, e^2 and radius^2 are
+ * split with twoProd.
+ * The exact value is the sum of those terms, which iFastSum
+ * rounds correctly, unless the products underflow
+ */
+template <typename fptype>
+fptype correctlyRoundedQuadric(const fptype *pos,
+                               const fptype *trans,
+                               fptype radius) {
+  constexpr const unsigned dim = QuadricBatch<fptype>::dim;
+  constexpr const unsigned numTerms = dim * 6 + 2;
+  fptype terms[numTerms];
+  unsigned numTerm = 0;
+  for(unsigned i = 0; i < dim; i++) {
+    const std::array<fptype, 2> modded =
+        twoSum(pos[i], trans[i]);
+    const std::array<fptype, 2> products[] = {
+        twoProd(modded[0], modded[0]),
+        twoProd(modded[0], fptype(2.0) * modded[1]),
+        twoProd(modded[1], modded[1])};
+    for(auto &prod : products) {
+      terms[numTerm++] = prod[0];
+      terms[numTerm++] = prod[1];
+    }
+  }
+  const std::array<fptype, 2> radiusSq =
+      twoProd(radius, radius);
+  terms[numTerm++] = -radiusSq[0];
+  terms[numTerm++] = -radiusSq[1];
+  return iFastSum(terms, numTerms);
+}
+
+#endif
@@ -0,0 +1,255 @@
+
+#include "numerictester.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+#include "quadratic.hpp"
+
+#include <algorithm>
+#include <random>
+#include <typeinfo>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <time.h>
+
+/* The precision of the statistics; the discriminants use
+ * QuadraticCase::referencePrecision
+ */
+constexpr const unsigned statBits = 1024;
+
+/* A batch of coefficient sets for a t^2 + b t + c.
+ * Half of the sets are uniform in [-1, 1];
+ * the rest have a double root t0, with c moved a few ulps,
+ * so the discriminant nearly cancels and its sign decides
+ * whether the roots are real.
+ * Every set has an exact MPFR discriminant, and MPFR roots
+ * in increasing order when they're real.
+ * The roots can't be exact; they're computed without
+ * cancellation from the exact discriminant, so they're
+ * within a few ulps of its precision
+ */
+template <typename fptype>
+class QuadraticCase : public NumericTester::TestCase {
+ public:
+  QuadraticCase(
+      std::mt19937_64 &rgen,
+      std::uniform_real_distribution<fptype> &dist,
+      unsigned numSets)
+      : NumericTester::TestCase(),
+        a(numSets),
+        b(numSets),
+        c(numSets),
+        correctReal(numSets),
+        correctRoots(2 * numSets) {
+    constexpr const int maxUlps = 4;
+    constexpr const fptype eps =
+        GenericFP::fpconvert<fptype>::epsilon;
+    std::uniform_int_distribution<int> ulps(-maxUlps,
+                                            maxUlps);
+    for(unsigned i = 0; i < numSets; i++) {
+      do {
+        a[i] = dist(rgen);
+      } while(a[i] == 0.0);
+      if(i % 2 == 0) {
+        b[i] = dist(rgen);
+        c[i] = dist(rgen);
+      } else {
+        const fptype root = dist(rgen);
+        b[i] = -2 * a[i] * root;
+        c[i] = a[i] * root * root;
+        c[i] += ulps(rgen) * std::fabs(c[i]) * eps;
+      }
+    }
+    const mpfr_prec_t prec = referencePrecision();
+    std::vector<mpfr::mpreal> discs(numSets);
+    beginExactReference();
+    for(unsigned i = 0; i < numSets; i++) {
+      mpfr::mpreal &disc = discs[i];
+      disc.set_prec(prec);
+      disc = b[i];
+      disc *= b[i];
+      mpfr::mpreal ac(a[i], prec);
+      ac *= c[i];
+      disc -= 4 * ac;
+    }
+    endExactReference();
+    for(unsigned i = 0; i < numSets; i++) {
+      correctReal[i] = discs[i] >= 0;
+      if(!correctReal[i]) continue;
+      /* q = -(b + sign(b) sqrt(disc)) / 2 doesn't cancel,
+       * and the roots are q / a and c / q
+       */
+      mpfr::mpreal q = mpfr::sqrt(discs[i]);
+      if(b[i] < 0) q = -q;
+      q += b[i];
+      q /= -2;
+      mpfr::mpreal r1 = q / a[i];
+      mpfr::mpreal r2 = q == 0 ? q : c[i] / q;
+      correctRoots[2 * i] = r1 < r2 ? r1 : r2;
+      correctRoots[2 * i + 1] = r1 < r2 ? r2 : r1;
+    }
+    correct = correctRoots[0];
+  }
+
+  unsigned size() const { return a.size(); }
+
+  std::vector<fptype> a, b, c;
+  std::vector<bool> correctReal;
+  std::vector<mpfr::mpreal> correctRoots;
+
+ private:
+  /* The least precision which holds every discriminant
+   * exactly; it sums 2 products of 2 coefficients, with
+   * 4 a c taken as (2 a) (2 c)
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    for(const std::vector<fptype> *coeffs : {&a, &b, &c}) {
+      for(fptype coeff : *coeffs) {
+        if(coeff == 0) continue;
+        const int exp = std::ilogb(coeff) + 1;
+        ulpExp = std::min(
+            ulpExp,
+            NumericTester::ulpExponent<fptype>(exp));
+        maxExp = std::max<long>(maxExp, exp + 1);
+      }
+    }
+    return NumericTester::exactPrecision(ulpExp, maxExp, 2,
+                                         2);
+  }
+};
+
+/* Roots of sets which are classified correctly as real
+ * are added to the statistics, apart from roots which are
+ * exactly 0.
+ * Throughput is reported as millions of sets solved per
+ * second
+ */
+template <typename fptype, typename solver>
+class QuadraticTest : public NumericTester::NumericTest {
+ public:
+  QuadraticTest()
+      : NumericTester::NumericTest(),
+        realAsComplex(0),
+        complexAsReal(0),
+        sets(0.0),
+        disc(),
+        low(),
+        high() {}
+
+  virtual std::string testName() {
+    return std::string(solver::name) +
+           " Quadratic Solver with " +
+           GenericFP::fpconvert<fptype>::fpname;
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const QuadraticCase<fptype>));
+    const QuadraticCase<fptype> *qCase =
+        static_cast<const QuadraticCase<fptype> *>(
+            &testCase);
+    const unsigned size = qCase->size();
+    disc.resize(size);
+    low.resize(size);
+    high.resize(size);
+    startTimer();
+    solveQuadratics<solver>(
+        qCase->a.data(), qCase->b.data(), qCase->c.data(),
+        disc.data(), low.data(), high.data(), size);
+    stopTimer();
+    sets += size;
+    for(unsigned i = 0; i < size; i++) {
+      const bool real = disc[i] >= 0.0;
+      if(real != qCase->correctReal[i]) {
+        if(real)
+          complexAsReal++;
+        else
+          realAsComplex++;
+        continue;
+      }
+      if(!real) continue;
+      const fptype roots[] = {low[i], high[i]};
+      for(unsigned r = 0; r < 2; r++) {
+        const mpfr::mpreal &correct =
+            qCase->correctRoots[2 * i + r];
+        if(correct == 0) continue;
+        mpfr::mpreal estimate(roots[r]);
+        addStatistic(estimate, correct);
+      }
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "Real Roots Classified as Complex: "
+        << realAsComplex << "\n"
+        << "Complex Roots Classified as Real: "
+        << complexAsReal << "\n"
+        << "Million Sets/s: " << sets / seconds / 1e6
+        << "\n";
+  }
+
+ private:
+  unsigned long realAsComplex;
+  unsigned long complexAsReal;
+  double sets;
+  std::vector<fptype> disc;
+  std::vector<fptype> low;
+  std::vector<fptype> high;
+};
+
+template <typename fptype>
+void runTests(std::mt19937_64 &engine, const int numTests,
+              const unsigned numSets) {
+  NumericTester::NumericTest *tests[] = {
+      new QuadraticTest<fptype, NaiveQuadratic>(),
+      new QuadraticTest<fptype, StableQuadratic>(),
+      new QuadraticTest<fptype, KahanQuadratic>(),
+      new QuadraticTest<fptype, DoubleDoubleQuadratic>()};
+  std::uniform_real_distribution<fptype> rgenf(-1.0, 1.0);
+  for(int i = 0; i < numTests; i++) {
+    QuadraticCase<fptype> testcase(engine, rgenf, numSets);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+int main(int argc, char **argv) {
+  int numTests = 256;
+  int numSets = 256;
+  if(argc > 1) {
+    numTests = atoi(argv[1]);
+    if(numTests < 1) {
+      printf("Number of tests must be greater than 0\n");
+      return -1;
+    }
+    if(argc > 2) {
+      numSets = atoi(argv[2]);
+      if(numSets < 1) {
+        printf("Batch size must be greater than 0\n");
+        return -1;
+      }
+    }
+  }
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  runTests<float>(engine, numTests, numSets);
+  runTests<double>(engine, numTests, numSets);
+  return 0;
+}
@@ -0,0 +1,199 @@
+
+#ifndef _RAY_QUADRIC_HPP_
+#define _RAY_QUADRIC_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "accurate_math.hpp"
+#include "simd.hpp"
+
+/* Intersection of rays with spheres and axis aligned
+ * cylinders, the surfaces of the points p with
+ *   sum_i weight[i] (p[i] + trans[i])^2 = radius^2,
+ * where every weight is 1 for a sphere, and a cylinder has
+ * a weight of 0 along its axis.
+ * The ray o + t d hits the surface where
+ *   a t^2 + 2 h t + c = 0,
+ * with a = |d|^2, h = d . (o + trans), and
+ * c = |o + trans|^2 - radius^2, all weighted.
+ * The kernels intersect a packet of rays at once, with a
+ * ray per lane, and return the smallest positive root,
+ * or infinity for rays which miss
+ */
+
+template <typename fptype>
+struct RayQuadric {
+  static constexpr const unsigned dim = 3;
+  fptype trans[dim];
+  fptype weight[dim];
+  fptype radius;
+};
+
+/* The rays stored as an array per coordinate */
+template <typename fptype>
+struct RayPacket {
+  static constexpr const unsigned dim = 3;
+  RayPacket(unsigned size) {
+    for(unsigned i = 0; i < dim; i++) {
+      origin[i].resize(size);
+      dir[i].resize(size);
+    }
+  }
+
+  unsigned size() const { return origin[0].size(); }
+
+  std::vector<fptype> origin[dim];
+  std::vector<fptype> dir[dim];
+};
+
+/* Picks the smaller positive root of t1 and t2,
+ * or infinity if the discriminant is negative or both
+ * roots are behind the origin
+ */
+template <typename fptype, typename vec>
+vec nearestHit(vec disc, vec t1, vec t2) {
+  const fptype inf =
+      std::numeric_limits<fptype>::infinity();
+  const vec tNear = t1 < t2 ? t1 : t2;
+  const vec tFar = t1 < t2 ? t2 : t1;
+  const vec dist = tNear > 0 ? tNear : tFar;
+  return (disc >= 0) & (tFar > 0) ? dist : vec{} + inf;
+}
+
+/* Computes the root of larger magnitude without
+ * cancellation, and the other from their product, c / a
+ */
+template <typename fptype, typename vec>
+vec stableNearestHit(vec a, vec h, vec c, vec disc) {
+  const vec sqrtDisc = SIMD::sqrt<fptype>(disc);
+  const vec q = -(h + (h < 0 ? -sqrtDisc : sqrtDisc));
+  return nearestHit<fptype>(disc, q / a, c / q);
+}
+
+struct NaiveRayKernel {
+  static constexpr const char *name = "Naive";
+  template <typename fptype, typename vec>
+  static vec intersect(const RayQuadric<fptype> &quadric,
+                       const vec (&origin)[3],
+                       const vec (&dir)[3]) {
+    vec a = {}, h = {};
+    vec c = vec{} - quadric.radius * quadric.radius;
+    for(unsigned i = 0; i < 3; i++) {
+      const vec d = dir[i] * quadric.weight[i];
+      const vec oc = (origin[i] + quadric.trans[i]) *
+                     quadric.weight[i];
+      a += d * d;
+      h += d * oc;
+      c += oc * oc;
+    }
+    const vec disc = h * h - a * c;
+    const vec sqrtDisc = SIMD::sqrt<fptype>(disc);
+    return nearestHit<fptype>(disc, (-h - sqrtDisc) / a,
+                              (-h + sqrtDisc) / a);
+  }
+};
+
+/* Every product is accumulated with an FMA, including the
+ * last product of the discriminant, and the roots are
+ * computed without cancellation
+ */
+struct FMARayKernel {
+  static constexpr const char *name = "FMA";
+  template <typename fptype, typename vec>
+  static vec intersect(const RayQuadric<fptype> &quadric,
+                       const vec (&origin)[3],
+                       const vec (&dir)[3]) {
+    vec a = {}, h = {};
+    vec c = vec{} - quadric.radius * quadric.radius;
+    for(unsigned i = 0; i < 3; i++) {
+      const vec d = dir[i] * quadric.weight[i];
+      const vec oc = (origin[i] + quadric.trans[i]) *
+                     quadric.weight[i];
+      a = SIMD::fma<fptype>(d, d, a);
+      h = SIMD::fma<fptype>(d, oc, h);
+      c = SIMD::fma<fptype>(oc, oc, c);
+    }
+    const vec disc = SIMD::fma<fptype>(h, h, -(a * c));
+    return stableNearestHit<fptype>(a, h, c, disc);
+  }
+};
+
+/* The translated origin is kept as an unevaluated sum,
+ * and the coefficients are summed from the exact products
+ * with Neumaier's compensation, keeping each coefficient's
+ * sum and error apart.
+ * The discriminant is formed from those pairs with exact
+ * products, so grazing rays are classified from about
+ * twice the precision, as the cancellation in h^2 - a c
+ * otherwise removes the bits that decide them
+ */
+struct CompensatedRayKernel {
+  static constexpr const char *name = "Compensated";
+  template <typename fptype, typename vec>
+  static vec intersect(const RayQuadric<fptype> &quadric,
+                       const vec (&origin)[3],
+                       const vec (&dir)[3]) {
+    vec a = {}, aErr = {};
+    vec h = {}, hErr = {};
+    std::array<vec, 2> r2 = twoProdDekker<fptype>(
+        vec{} + quadric.radius, vec{} + quadric.radius);
+    vec c = -r2[0], cErr = -r2[1];
+    for(unsigned i = 0; i < 3; i++) {
+      const vec d = dir[i] * quadric.weight[i];
+      std::array<vec, 2> oc = twoSumBranchFree(
+          origin[i], vec{} + quadric.trans[i]);
+      oc[0] *= quadric.weight[i];
+      oc[1] *= quadric.weight[i];
+      std::array<vec, 2> dd = twoProdDekker<fptype>(d, d);
+      aErr += dd[1];
+      neumaierAddBranchFree(a, aErr, dd[0]);
+      std::array<vec, 2> doc =
+          twoProdDekker<fptype>(d, oc[0]);
+      hErr += doc[1] + d * oc[1];
+      neumaierAddBranchFree(h, hErr, doc[0]);
+      std::array<vec, 2> ococ =
+          twoProdDekker<fptype>(oc[0], oc[0]);
+      cErr += ococ[1] + fptype(2.0) * oc[0] * oc[1];
+      neumaierAddBranchFree(c, cErr, ococ[0]);
+    }
+    std::array<vec, 2> hh = twoProdDekker<fptype>(h, h);
+    std::array<vec, 2> ac = twoProdDekker<fptype>(a, c);
+    const vec lowTerms = fptype(2.0) * h * hErr -
+                         (a * cErr + aErr * c);
+    const vec disc = (hh[0] - ac[0]) +
+                     ((hh[1] - ac[1]) + lowTerms);
+    return stableNearestHit<fptype>(a + aErr, h + hErr,
+                                    c + cErr, disc);
+  }
+};
+
+/* Writes the distance to the nearest hit of every ray */
+template <typename kernel, typename fptype>
+void intersectRays(const RayQuadric<fptype> &quadric,
+                   const RayPacket<fptype> &rays,
+                   fptype *dist) {
+  using vec = typename SIMD::Vector<fptype>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<fptype>::lanes;
+  const unsigned count = rays.size();
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    vec origin[3], dir[3];
+    for(unsigned i = 0; i < 3; i++) {
+      origin[i] = SIMD::loadPartial(
+          rays.origin[i].data() + j, width);
+      dir[i] =
+          SIMD::loadPartial(rays.dir[i].data() + j, width);
+    }
+    vec hit =
+        kernel::template intersect<fptype>(quadric, origin,
+                                           dir);
+    SIMD::storePartial(dist + j, hit, width);
+  }
+}
+
+#endif
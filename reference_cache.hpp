@@ -0,0 +1,209 @@
+
+#ifndef _REFERENCE_CACHE_HPP_
+#define _REFERENCE_CACHE_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <assert.h>
+
+#include "mpreal.h"
+
+/* A file of the references of a seeded run's cases, by the
+ * index of the case.
+ * The header holds the seed and the configuration of the
+ * case generator; a file written with different ones is
+ * ignored, and replaced when the cache is saved.
+ * References are stored exactly, as MPFR's kind, exponent
+ * and limbs at the precision in the header, so loading one
+ * gives the value the case would have computed.
+ * The file is mapped when the cache is opened; references
+ * of the cases beyond it are stored in memory, and written
+ * after the mapped ones by save
+ */
+class ReferenceCache {
+ public:
+  ReferenceCache(const std::string &fname, uint64_t seed,
+                 const std::vector<uint64_t> &config,
+                 mpfr_prec_t prec)
+      : fname(fname),
+        seed(seed),
+        config(config),
+        prec(prec),
+        recordLimbs(2 + numLimbs(prec)),
+        mapping(MAP_FAILED),
+        mappedBytes(0),
+        records(NULL),
+        numMapped(0),
+        added() {
+    static_assert(sizeof(mp_limb_t) == sizeof(uint64_t),
+                  "Records are stored in 64 bit words");
+    map();
+  }
+
+  ~ReferenceCache() {
+    if(mapping != MAP_FAILED) munmap(mapping, mappedBytes);
+  }
+
+  ReferenceCache(const ReferenceCache &) = delete;
+  ReferenceCache &operator=(const ReferenceCache &) =
+      delete;
+
+  /* The number of references cached; they're the cases
+   * with indices below it
+   */
+  unsigned long size() const {
+    return numMapped + added.size() / recordLimbs;
+  }
+
+  unsigned long mappedSize() const { return numMapped; }
+
+  /* Sets ref to the reference of a case from the file */
+  void load(unsigned long index, mpfr::mpreal &ref) const {
+    assert(index < numMapped);
+    const mp_limb_t *record = records + index * recordLimbs;
+    mpfr_t stored;
+    mpfr_custom_init_set(
+        stored, static_cast<int>(record[0]),
+        static_cast<mpfr_exp_t>(record[1]), prec,
+        const_cast<mp_limb_t *>(record + 2));
+    ref.set_prec(prec);
+    mpfr_set(ref.mpfr_ptr(), stored, MPFR_RNDN);
+  }
+
+  /* Adds the reference of the next case, which must have
+   * the cache's precision
+   */
+  void store(unsigned long index, const mpfr::mpreal &ref) {
+    assert(index == size());
+    assert(ref.get_prec() == prec);
+    const int kind =
+        mpfr_custom_get_kind(ref.mpfr_srcptr());
+    added.push_back(static_cast<mp_limb_t>(kind));
+    const bool regular = kind == MPFR_REGULAR_KIND ||
+                         kind == -MPFR_REGULAR_KIND;
+    added.push_back(static_cast<mp_limb_t>(
+        regular ? mpfr_custom_get_exp(ref.mpfr_srcptr())
+                : 0));
+    const mp_limb_t *limbs = static_cast<const mp_limb_t *>(
+        mpfr_custom_get_significand(ref.mpfr_srcptr()));
+    for(unsigned i = 0; i < recordLimbs - 2; i++)
+      added.push_back(regular ? limbs[i] : 0);
+  }
+
+  /* Writes the file if references were added, through a
+   * temporary file, so an interrupted save leaves the old
+   * one.
+   * Throws a WriteError if the file can't be written
+   */
+  void save() {
+    if(added.empty()) return;
+    const std::string tmpName = fname + ".tmp";
+    {
+      std::ofstream out(tmpName,
+                        std::ios::out | std::ios::binary);
+      const Header header = makeHeader(size());
+      write(out, &header, sizeof(header));
+      write(out, config.data(),
+            config.size() * sizeof(uint64_t));
+      write(out, records,
+            numMapped * recordLimbs * sizeof(mp_limb_t));
+      write(out, added.data(),
+            added.size() * sizeof(mp_limb_t));
+      if(!out) throw WriteError();
+    }
+    if(std::rename(tmpName.c_str(), fname.c_str()) != 0)
+      throw WriteError();
+  }
+
+  class WriteError {};
+
+ private:
+  struct Header {
+    char magic[8];
+    uint64_t seed;
+    uint64_t prec;
+    uint64_t configSize;
+    uint64_t numRecords;
+  };
+
+  static void write(std::ofstream &out, const void *data,
+                    size_t bytes) {
+    out.write(static_cast<const char *>(data), bytes);
+  }
+
+  static unsigned numLimbs(mpfr_prec_t prec) {
+    return (prec + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+  }
+
+  Header makeHeader(uint64_t numRecords) const {
+    static const char magic[] = "NTREFS1";
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.seed = seed;
+    header.prec = prec;
+    header.configSize = config.size();
+    header.numRecords = numRecords;
+    return header;
+  }
+
+  /* Maps the file, if it exists and was written with the
+   * same seed, configuration and precision
+   */
+  void map() {
+    const int fd = open(fname.c_str(), O_RDONLY);
+    if(fd < 0) return;
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) == 0 &&
+       fileStat.st_size >= (off_t)sizeof(Header)) {
+      mappedBytes = fileStat.st_size;
+      mapping = mmap(NULL, mappedBytes, PROT_READ,
+                     MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if(mapping == MAP_FAILED) return;
+    const Header *header =
+        static_cast<const Header *>(mapping);
+    const Header expected = makeHeader(header->numRecords);
+    const uint64_t *fileConfig =
+        reinterpret_cast<const uint64_t *>(header + 1);
+    const size_t dataOffset =
+        sizeof(Header) + config.size() * sizeof(uint64_t);
+    if(std::memcmp(header, &expected, sizeof(Header)) !=
+           0 ||
+       mappedBytes !=
+           dataOffset + header->numRecords * recordLimbs *
+                            sizeof(mp_limb_t) ||
+       std::memcmp(fileConfig, config.data(),
+                   config.size() * sizeof(uint64_t)) != 0) {
+      munmap(mapping, mappedBytes);
+      mapping = MAP_FAILED;
+      return;
+    }
+    records = reinterpret_cast<const mp_limb_t *>(
+        static_cast<const char *>(mapping) + dataOffset);
+    numMapped = header->numRecords;
+  }
+
+  const std::string fname;
+  const uint64_t seed;
+  const std::vector<uint64_t> config;
+  const mpfr_prec_t prec;
+  const unsigned recordLimbs;
+  void *mapping;
+  size_t mappedBytes;
+  const mp_limb_t *records;
+  unsigned long numMapped;
+  std::vector<mp_limb_t> added;
+};
+
+#endif
@@ -0,0 +1,150 @@
+
+#ifndef _SIMD_HPP_
+#define _SIMD_HPP_
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace SIMD {
+
+/* The widest vector register the target provides.
+ * Kernels are written with GCC's vector extensions,
+ * so without -march support for these they are lowered
+ * to narrower registers rather than failing to compile
+ */
+#if defined(__AVX512F__)
+constexpr const unsigned vecBytes = 64;
+#elif defined(__AVX__)
+constexpr const unsigned vecBytes = 32;
+#else
+constexpr const unsigned vecBytes = 16;
+#endif
+
+/* Only float and double have vector registers;
+ * long double is not supported
+ */
+template <typename fptype>
+struct Vector {
+  static constexpr const unsigned lanes =
+      vecBytes / sizeof(fptype);
+  typedef fptype type
+      __attribute__((vector_size(vecBytes)));
+};
+
+/* Unaligned load of a full vector of lanes */
+template <typename fptype>
+typename Vector<fptype>::type load(const fptype *src) {
+  typename Vector<fptype>::type vec;
+  std::memcpy(&vec, src, sizeof(vec));
+  return vec;
+}
+
+/* Load of a partial vector of lanes,
+ * with the unused lanes set to 0
+ */
+template <typename fptype>
+typename Vector<fptype>::type loadPartial(
+    const fptype *src, unsigned count) {
+  typename Vector<fptype>::type vec = {};
+  std::memcpy(&vec, src, count * sizeof(fptype));
+  return vec;
+}
+
+/* Unaligned store of the first count lanes */
+template <typename fptype>
+void storePartial(fptype *dest,
+                  const typename Vector<fptype>::type &vec,
+                  unsigned count) {
+  std::memcpy(dest, &vec, count * sizeof(fptype));
+}
+
+/* GCC's vector extensions have no square root or FMA,
+ * so these apply the scalar functions lane by lane,
+ * unless the target's intrinsics are available below.
+ * GCC doesn't reliably vectorize the lane loops again,
+ * and the square root's errno handling prevents it
+ */
+template <typename fptype>
+typename Vector<fptype>::type sqrt(
+    typename Vector<fptype>::type vec) {
+  for(unsigned i = 0; i < Vector<fptype>::lanes; i++)
+    vec[i] = std::sqrt(vec[i]);
+  return vec;
+}
+
+template <typename fptype>
+typename Vector<fptype>::type fma(
+    typename Vector<fptype>::type a,
+    typename Vector<fptype>::type b,
+    typename Vector<fptype>::type c) {
+  for(unsigned i = 0; i < Vector<fptype>::lanes; i++)
+    c[i] = std::fma(a[i], b[i], c[i]);
+  return c;
+}
+
+#if defined(__SSE2__)
+/* The x86 intrinsics for the width of Vector */
+#if defined(__AVX512F__)
+#define SIMD_X86(name) _mm512_##name
+#elif defined(__AVX__)
+#define SIMD_X86(name) _mm256_##name
+#else
+#define SIMD_X86(name) _mm_##name
+#endif
+
+/* GCC's _mm512_sqrt intrinsics merge into an undefined
+ * vector, which -Wmaybe-uninitialized reports wherever they
+ * are inlined; the zero masked forms with every lane
+ * selected compile to the same instruction without it
+ */
+#if defined(__AVX512F__)
+template <>
+inline Vector<float>::type sqrt<float>(
+    Vector<float>::type vec) {
+  return _mm512_maskz_sqrt_ps(__mmask16(~0), vec);
+}
+
+template <>
+inline Vector<double>::type sqrt<double>(
+    Vector<double>::type vec) {
+  return _mm512_maskz_sqrt_pd(__mmask8(~0), vec);
+}
+#else
+template <>
+inline Vector<float>::type sqrt<float>(
+    Vector<float>::type vec) {
+  return SIMD_X86(sqrt_ps)(vec);
+}
+
+template <>
+inline Vector<double>::type sqrt<double>(
+    Vector<double>::type vec) {
+  return SIMD_X86(sqrt_pd)(vec);
+}
+#endif
+
+#if defined(__FMA__) || defined(__AVX512F__)
+template <>
+inline Vector<float>::type fma<float>(
+    Vector<float>::type a, Vector<float>::type b,
+    Vector<float>::type c) {
+  return SIMD_X86(fmadd_ps)(a, b, c);
+}
+
+template <>
+inline Vector<double>::type fma<double>(
+    Vector<double>::type a, Vector<double>::type b,
+    Vector<double>::type c) {
+  return SIMD_X86(fmadd_pd)(a, b, c);
+}
+#endif
+
+#undef SIMD_X86
+#endif
+}
+
+#endif
@@ -0,0 +1,121 @@
+
+#ifndef _SORTED_SUM_HPP_
+#define _SORTED_SUM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "kobbelt.hpp"
+
+/* Sorting the summands by magnitude before summing them.
+ * The sort is an LSD radix sort on integer keys formed
+ * from the floating point bit patterns,
+ * which is linear in the number of summands
+ */
+
+/* The unsigned integer type with the same size as fptype;
+ * only float and double are supported
+ */
+template <typename fptype>
+using SortKey = typename std::conditional<
+    sizeof(fptype) == sizeof(uint32_t), uint32_t,
+    uint64_t>::type;
+
+template <typename fptype>
+SortKey<fptype> fpBits(fptype val) {
+  static_assert(sizeof(fptype) == sizeof(SortKey<fptype>),
+                "Only float and double have sort keys");
+  SortKey<fptype> bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  return bits;
+}
+
+/* The bit patterns of non-negative IEEE 754 values are
+ * ordered like the values, so clearing the sign bit gives
+ * a key ordered by magnitude
+ */
+template <typename fptype>
+struct IncreasingMagnitude {
+  static constexpr const char *name =
+      "Increasing Magnitude";
+  static SortKey<fptype> key(fptype val) {
+    constexpr const SortKey<fptype> signBit =
+        SortKey<fptype>(1) << (sizeof(fptype) * 8 - 1);
+    return fpBits(val) & ~signBit;
+  }
+};
+
+template <typename fptype>
+struct DecreasingMagnitude {
+  static constexpr const char *name =
+      "Decreasing Magnitude";
+  static SortKey<fptype> key(fptype val) {
+    return ~IncreasingMagnitude<fptype>::key(val);
+  }
+};
+
+/* Orders the values like kobbeltDotProd's table */
+template <typename fptype>
+struct IncreasingGenus {
+  static constexpr const char *name = "Increasing Genus";
+  static SortKey<fptype> key(fptype val) {
+    return computeGenus(val);
+  }
+};
+
+/* Stable LSD radix sort of vals by order::key,
+ * one byte per pass.
+ * scratch must hold size values; the sorted values are
+ * left in vals.
+ * The histograms for all passes are built in one sweep,
+ * and passes where every key has the same digit are
+ * skipped, which is common for the high bytes of values
+ * with similar magnitudes
+ */
+template <typename fptype, typename order>
+void radixSort(fptype *vals, fptype *scratch,
+               unsigned size) {
+  constexpr const unsigned digitBits = 8;
+  constexpr const unsigned radix = 1u << digitBits;
+  constexpr const unsigned numPasses =
+      sizeof(SortKey<fptype>);
+  if(size == 0) return;
+  std::array<std::array<unsigned, radix>, numPasses>
+      counts = {};
+  for(unsigned i = 0; i < size; i++) {
+    SortKey<fptype> key = order::key(vals[i]);
+    for(unsigned p = 0; p < numPasses; p++) {
+      counts[p][key & (radix - 1)]++;
+      key >>= digitBits;
+    }
+  }
+  fptype *src = vals;
+  fptype *dest = scratch;
+  for(unsigned p = 0; p < numPasses; p++) {
+    const unsigned shift = p * digitBits;
+    const unsigned first =
+        (order::key(src[0]) >> shift) & (radix - 1);
+    if(counts[p][first] == size) continue;
+    /* Convert the counts into starting offsets */
+    unsigned offset = 0;
+    for(unsigned d = 0; d < radix; d++) {
+      unsigned count = counts[p][d];
+      counts[p][d] = offset;
+      offset += count;
+    }
+    for(unsigned i = 0; i < size; i++) {
+      const unsigned digit =
+          (order::key(src[i]) >> shift) & (radix - 1);
+      dest[counts[p][digit]] = src[i];
+      counts[p][digit]++;
+    }
+    std::swap(src, dest);
+  }
+  if(src != vals)
+    std::memcpy(vals, src, size * sizeof(fptype));
+}
+
+#endif
@@ -0,0 +1,370 @@
+
+#ifndef _SPARSE_HPP_
+#define _SPARSE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "accurate_math.hpp"
+#include "worker_pool.hpp"
+
+/* A sparse matrix in compressed sparse row format.
+ * The nonzeros of row r are at indices
+ * rowStart[r] to rowStart[r + 1] - 1 of values and
+ * colIndex, sorted by column
+ */
+template <typename fptype>
+struct CSRMatrix {
+  CSRMatrix() : rows(0), cols(0), rowStart(1, 0) {}
+
+  unsigned nonzeros() const { return rowStart[rows]; }
+  unsigned rowLength(unsigned r) const {
+    return rowStart[r + 1] - rowStart[r];
+  }
+
+  unsigned rows, cols;
+  std::vector<unsigned> rowStart;
+  std::vector<unsigned> colIndex;
+  std::vector<fptype> values;
+};
+
+/* Builds the CSR matrix from unordered (row, column, value)
+ * triples with a counting sort on the rows
+ */
+template <typename fptype>
+CSRMatrix<fptype> buildCSR(
+    unsigned rows, unsigned cols,
+    const std::vector<std::pair<unsigned, unsigned>> &pos,
+    const std::vector<fptype> &vals) {
+  CSRMatrix<fptype> matrix;
+  matrix.rows = rows;
+  matrix.cols = cols;
+  matrix.rowStart.assign(rows + 1, 0);
+  for(auto &entry : pos) matrix.rowStart[entry.first + 1]++;
+  for(unsigned r = 0; r < rows; r++)
+    matrix.rowStart[r + 1] += matrix.rowStart[r];
+  matrix.colIndex.resize(pos.size());
+  matrix.values.resize(pos.size());
+  std::vector<unsigned> next(matrix.rowStart.begin(),
+                             matrix.rowStart.end() - 1);
+  for(unsigned i = 0; i < pos.size(); i++) {
+    unsigned dest = next[pos[i].first]++;
+    matrix.colIndex[dest] = pos[i].second;
+    matrix.values[dest] = vals[i];
+  }
+  std::vector<std::pair<unsigned, fptype>> row;
+  for(unsigned r = 0; r < rows; r++) {
+    const unsigned begin = matrix.rowStart[r];
+    const unsigned end = matrix.rowStart[r + 1];
+    row.clear();
+    for(unsigned i = begin; i < end; i++)
+      row.push_back({matrix.colIndex[i], matrix.values[i]});
+    std::sort(row.begin(), row.end(),
+              [](const std::pair<unsigned, fptype> &lhs,
+                 const std::pair<unsigned, fptype> &rhs) {
+                return lhs.first < rhs.first;
+              });
+    for(unsigned i = begin; i < end; i++) {
+      matrix.colIndex[i] = row[i - begin].first;
+      matrix.values[i] = row[i - begin].second;
+    }
+  }
+  return matrix;
+}
+
+class MatrixMarketError {};
+
+/* A read only private mapping of a whole file */
+class MappedFile {
+ public:
+  MappedFile(const std::string &fname)
+      : mapping(nullptr), length(0) {
+    int fd = open(fname.c_str(), O_RDONLY);
+    if(fd < 0) throw MatrixMarketError();
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0) {
+      close(fd);
+      throw MatrixMarketError();
+    }
+    length = info.st_size;
+    void *addr = mmap(nullptr, length, PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) throw MatrixMarketError();
+    mapping = static_cast<const char *>(addr);
+    madvise(addr, length, MADV_SEQUENTIAL);
+  }
+
+  ~MappedFile() {
+    munmap(const_cast<char *>(mapping), length);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return mapping; }
+  size_t size() const { return length; }
+
+ private:
+  const char *mapping;
+  size_t length;
+};
+
+/* Whitespace separated tokens of a buffer which is not
+ * null terminated, so every read is bounds checked
+ */
+class Scanner {
+ public:
+  Scanner(const char *begin, const char *end)
+      : pos(begin), end(end) {}
+
+  int peek() {
+    skipSpace();
+    return pos < end ? *pos : -1;
+  }
+
+  void skipLine() {
+    while(pos < end && *pos != '\n') pos++;
+    if(pos < end) pos++;
+  }
+
+  std::string token() {
+    skipSpace();
+    const char *begin = pos;
+    while(pos < end && !isSpace(*pos)) pos++;
+    if(begin == pos) throw MatrixMarketError();
+    return std::string(begin, pos);
+  }
+
+  unsigned parseUnsigned() {
+    skipSpace();
+    if(pos == end || !isDigit(*pos))
+      throw MatrixMarketError();
+    unsigned long val = 0;
+    while(pos < end && isDigit(*pos)) {
+      val = val * 10 + (*pos - '0');
+      pos++;
+    }
+    return val;
+  }
+
+  /* strtod needs a null terminated string */
+  double parseReal() {
+    skipSpace();
+    char buf[64];
+    unsigned len = 0;
+    while(pos < end && !isSpace(*pos)) {
+      if(len + 1 == sizeof(buf)) throw MatrixMarketError();
+      buf[len] = *pos;
+      len++;
+      pos++;
+    }
+    buf[len] = '\0';
+    char *parsed;
+    double val = std::strtod(buf, &parsed);
+    if(len == 0 || parsed != buf + len)
+      throw MatrixMarketError();
+    return val;
+  }
+
+ private:
+  static bool isSpace(char c) {
+    return std::isspace((unsigned char)c);
+  }
+
+  static bool isDigit(char c) {
+    return std::isdigit((unsigned char)c);
+  }
+
+  void skipSpace() {
+    while(pos < end && isSpace(*pos)) pos++;
+  }
+
+  const char *pos;
+  const char *end;
+};
+
+/* Reads the coordinate format of the MatrixMarket exchange
+ * format, with real, integer, or pattern entries and
+ * general, symmetric, or skew-symmetric storage.
+ * The file is memory mapped and parsed in place,
+ * so it is never copied into a stream buffer.
+ * Throws a MatrixMarketError if the file can't be read or
+ * is malformed
+ */
+template <typename fptype>
+CSRMatrix<fptype> readMatrixMarket(
+    const std::string &fname) {
+  MappedFile file(fname);
+  Scanner scan(file.data(), file.data() + file.size());
+  std::array<std::string, 5> header;
+  for(auto &field : header) field = scan.token();
+  for(auto &field : header) {
+    for(auto &c : field)
+      c = std::tolower((unsigned char)c);
+  }
+  if(header[0] != "%%matrixmarket" ||
+     header[1] != "matrix" || header[2] != "coordinate")
+    throw MatrixMarketError();
+  const bool pattern = header[3] == "pattern";
+  if(!pattern && header[3] != "real" &&
+     header[3] != "integer")
+    throw MatrixMarketError();
+  const bool symmetric = header[4] == "symmetric";
+  const bool skew = header[4] == "skew-symmetric";
+  if(!symmetric && !skew && header[4] != "general")
+    throw MatrixMarketError();
+  scan.skipLine();
+  while(scan.peek() == '%') scan.skipLine();
+  const unsigned rows = scan.parseUnsigned();
+  const unsigned cols = scan.parseUnsigned();
+  const unsigned entries = scan.parseUnsigned();
+  std::vector<std::pair<unsigned, unsigned>> pos;
+  std::vector<fptype> vals;
+  pos.reserve(symmetric || skew ? 2 * entries : entries);
+  vals.reserve(pos.capacity());
+  for(unsigned i = 0; i < entries; i++) {
+    const unsigned r = scan.parseUnsigned() - 1;
+    const unsigned c = scan.parseUnsigned() - 1;
+    if(r >= rows || c >= cols) throw MatrixMarketError();
+    const fptype val = pattern ? 1.0 : scan.parseReal();
+    pos.push_back({r, c});
+    vals.push_back(val);
+    if((symmetric || skew) && r != c) {
+      pos.push_back({c, r});
+      vals.push_back(skew ? -val : val);
+    }
+  }
+  return buildCSR(rows, cols, pos, vals);
+}
+
+/* Splits the rows into numThreads contiguous ranges with
+ * about the same number of nonzeros each;
+ * thread t computes rows boundary[t] to boundary[t + 1] - 1
+ */
+template <typename fptype>
+std::vector<unsigned> partitionByNonzeros(
+    const CSRMatrix<fptype> &matrix, unsigned numThreads) {
+  std::vector<unsigned> boundary(numThreads + 1);
+  const unsigned long nonzeros = matrix.nonzeros();
+  for(unsigned t = 0; t < numThreads; t++) {
+    const unsigned target = nonzeros * t / numThreads;
+    auto first = matrix.rowStart.begin();
+    boundary[t] = std::lower_bound(
+                      first, matrix.rowStart.end() - 1,
+                      target) -
+                  first;
+  }
+  boundary[numThreads] = matrix.rows;
+  return boundary;
+}
+
+/* The row kernels compute the dot product of a sparse row
+ * with the gathered entries of x
+ */
+struct NaiveRow {
+  static constexpr const char *name = "Naive";
+  template <typename fptype>
+  static fptype dot(const fptype *vals,
+                    const unsigned *cols, unsigned len,
+                    const fptype *x) {
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < len; i++)
+      accumulator += vals[i] * x[cols[i]];
+    return accumulator;
+  }
+};
+
+struct FMARow {
+  static constexpr const char *name = "FMA";
+  template <typename fptype>
+  static fptype dot(const fptype *vals,
+                    const unsigned *cols, unsigned len,
+                    const fptype *x) {
+    fptype accumulator = 0.0;
+    for(unsigned i = 0; i < len; i++)
+      accumulator =
+          std::fma(vals[i], x[cols[i]], accumulator);
+    return accumulator;
+  }
+};
+
+struct KahanRow {
+  static constexpr const char *name = "Kahan";
+  template <typename fptype>
+  static fptype dot(const fptype *vals,
+                    const unsigned *cols, unsigned len,
+                    const fptype *x) {
+    fptype accumulator = 0.0;
+    fptype c = 0.0;
+    for(unsigned i = 0; i < len; i++) {
+      fptype mod = vals[i] * x[cols[i]] - c;
+      fptype tmp = accumulator + mod;
+      c = (tmp - accumulator) - mod;
+      accumulator = tmp;
+    }
+    return accumulator;
+  }
+};
+
+/* Ogita, Rump, and Oishi's Dot2 */
+struct Dot2Row {
+  static constexpr const char *name = "Dot2";
+  template <typename fptype>
+  static fptype dot(const fptype *vals,
+                    const unsigned *cols, unsigned len,
+                    const fptype *x) {
+    fptype sum = 0.0;
+    fptype c = 0.0;
+    for(unsigned i = 0; i < len; i++) {
+      std::array<fptype, 2> prod =
+          twoProd(vals[i], x[cols[i]]);
+      std::array<fptype, 2> acc = twoSum(sum, prod[0]);
+      sum = acc[0];
+      c += acc[1] + prod[1];
+    }
+    return sum + c;
+  }
+};
+
+template <typename rowkernel, typename fptype>
+void spmvRows(const CSRMatrix<fptype> &matrix,
+              const fptype *x, fptype *y, unsigned first,
+              unsigned last) {
+  for(unsigned r = first; r < last; r++) {
+    const unsigned begin = matrix.rowStart[r];
+    y[r] = rowkernel::dot(matrix.values.data() + begin,
+                          matrix.colIndex.data() + begin,
+                          matrix.rowLength(r), x);
+  }
+}
+
+/* y = A x, with the rows split between the pool's threads
+ * by partitionByNonzeros; boundary must have one range per
+ * thread of the pool
+ */
+template <typename rowkernel, typename fptype>
+void spmv(const CSRMatrix<fptype> &matrix, const fptype *x,
+          fptype *y, const std::vector<unsigned> &boundary,
+          WorkerPool &pool) {
+  assert(boundary.size() == pool.size() + 1);
+  pool.run([&](unsigned t) {
+    spmvRows<rowkernel>(matrix, x, y, boundary[t],
+                        boundary[t + 1]);
+  });
+}
+
+#endif
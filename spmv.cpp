@@ -0,0 +1,310 @@
+
+#include "numerictester.hpp"
+#include "genericfp.hpp"
+#include "mpreal.h"
+#include "sparse.hpp"
+
+#include <algorithm>
+#include <random>
+#include <typeinfo>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <assert.h>
+#include <time.h>
+
+/* The precision of the statistics; the references use
+ * SpMVCase::referencePrecision
+ */
+constexpr const unsigned statBits = 1024;
+
+/* A random x for a fixed matrix, with an MPFR reference
+ * for every row of A x
+ */
+template <typename fptype>
+class SpMVCase : public NumericTester::TestCase {
+ public:
+  SpMVCase(std::mt19937_64 &rgen,
+           std::uniform_real_distribution<fptype> &dist,
+           const CSRMatrix<fptype> &matrix)
+      : NumericTester::TestCase(),
+        matrix(matrix),
+        x(matrix.cols),
+        correctRows(matrix.rows) {
+    for(auto &val : x) val = dist(rgen);
+    const mpfr_prec_t prec = referencePrecision();
+    beginExactReference();
+    for(unsigned r = 0; r < matrix.rows; r++) {
+      mpfr::mpreal accumulator(0.0, prec);
+      for(unsigned i = matrix.rowStart[r];
+          i < matrix.rowStart[r + 1]; i++) {
+        mpfr::mpreal prod(matrix.values[i], prec);
+        prod *= x[matrix.colIndex[i]];
+        accumulator += prod;
+      }
+      correctRows[r] = accumulator;
+    }
+    endExactReference();
+    if(matrix.rows > 0) correct = correctRows[0];
+  }
+
+  const CSRMatrix<fptype> &matrix;
+  std::vector<fptype> x;
+  std::vector<mpfr::mpreal> correctRows;
+
+ private:
+  /* The least precision which holds every row exactly,
+   * from the exponents of the matrix and x, as a
+   * MatrixMarket file may have any values; a row sums up
+   * to the longest row's length of products of 2 factors
+   */
+  mpfr_prec_t referencePrecision() const {
+    long ulpExp = NumericTester::ulpExponent<fptype>(1);
+    long maxExp = 1;
+    auto include = [&](fptype val) {
+      if(val == 0 || !std::isfinite(val)) return;
+      const int exp = std::ilogb(val) + 1;
+      ulpExp = std::min(
+          ulpExp, NumericTester::ulpExponent<fptype>(exp));
+      maxExp = std::max<long>(maxExp, exp);
+    };
+    for(fptype val : matrix.values) include(val);
+    for(fptype val : x) include(val);
+    unsigned maxLength = 1;
+    for(unsigned r = 0; r < matrix.rows; r++)
+      maxLength = std::max(maxLength, matrix.rowLength(r));
+    return NumericTester::exactPrecision(ulpExp, maxExp, 2,
+                                         maxLength);
+  }
+};
+
+/* The errors of the rows whose lengths fall in one bucket.
+ * Buckets are filled by their SpMVTest rather than from
+ * test cases directly
+ */
+class RowBucketStats : public NumericTester::NumericTest {
+ public:
+  RowBucketStats(const std::string &name)
+      : NumericTester::NumericTest(), name(name) {}
+
+  virtual std::string testName() { return name; }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &) {
+    assert(false);
+  }
+
+  void add(const mpfr::mpreal &estimate,
+           const mpfr::mpreal &correct) {
+    addStatistic(estimate, correct);
+  }
+
+  unsigned count() const { return relErrors.size(); }
+
+  /* The bucket isn't timed, so only print the errors */
+  virtual void printStats(std::ostream &out = std::cout) {
+    std::array<mpfr::mpreal, 2> percent =
+        calcRelErrorPercentile(0.99);
+    out << testName() << "\n"
+        << "Rows: " << count() << "\n"
+        << "Relative Error Average: " << calcRelErrorAvg()
+        << "\n"
+        << "Relative Error Maximum: " << calcRelErrorMax()
+        << "\n"
+        << "Relative Error 99th Percentile: " << percent[0]
+        << ", " << percent[1] << "\n";
+  }
+
+ private:
+  std::string name;
+};
+
+/* Rows are bucketed by the power of 2 below their length.
+ * Rows whose exact value is 0 have no relative error,
+ * so they are left out of the statistics
+ */
+template <typename fptype, typename rowkernel>
+class SpMVTest : public NumericTester::NumericTest {
+ public:
+  SpMVTest(unsigned numThreads)
+      : NumericTester::NumericTest(),
+        numThreads(numThreads),
+        pool(numThreads),
+        flops(0.0),
+        y(),
+        buckets() {
+    useWallClock();
+  }
+
+  virtual std::string testName() {
+    return std::string(rowkernel::name) + " SpMV with " +
+           GenericFP::fpconvert<fptype>::fpname + ", " +
+           std::to_string(numThreads) + " Threads";
+  }
+
+  virtual void updateStats(
+      const NumericTester::TestCase &testCase) {
+    assert(typeid(testCase) ==
+           typeid(const SpMVCase<fptype>));
+    const SpMVCase<fptype> *spCase =
+        static_cast<const SpMVCase<fptype> *>(&testCase);
+    const CSRMatrix<fptype> &matrix = spCase->matrix;
+    std::vector<unsigned> boundary =
+        partitionByNonzeros(matrix, numThreads);
+    y.resize(matrix.rows);
+    startTimer();
+    spmv<rowkernel>(matrix, spCase->x.data(), y.data(),
+                    boundary, pool);
+    stopTimer();
+    flops += 2.0 * matrix.nonzeros();
+    for(unsigned r = 0; r < matrix.rows; r++) {
+      const mpfr::mpreal &correct = spCase->correctRows[r];
+      if(correct == 0) continue;
+      mpfr::mpreal estimate(y[r]);
+      addStatistic(estimate, correct);
+      bucket(matrix.rowLength(r)).add(estimate, correct);
+    }
+  }
+
+  virtual void printStats(std::ostream &out = std::cout) {
+    NumericTester::NumericTest::printStats(out);
+    struct timespec time = totalRunTime();
+    double seconds = time.tv_sec + time.tv_nsec * 1e-9;
+    out << "GFLOP/s: " << flops / seconds / 1e9 << "\n";
+    for(auto &rowBucket : buckets) {
+      /* The variance needs at least 2 rows */
+      if(rowBucket.count() < 2) continue;
+      out << "\n";
+      rowBucket.printStats(out);
+    }
+  }
+
+ private:
+  RowBucketStats &bucket(unsigned rowLength) {
+    unsigned index = 0;
+    while((2ul << index) <= rowLength) index++;
+    while(buckets.size() <= index) {
+      const unsigned long low = 1ul << buckets.size();
+      const std::string high = std::to_string(2 * low - 1);
+      buckets.emplace_back(
+          low == 1 ? std::string("Rows with 1 Nonzero")
+                   : "Rows with " + std::to_string(low) +
+                         " to " + high + " Nonzeros");
+    }
+    return buckets[index];
+  }
+
+  const unsigned numThreads;
+  WorkerPool pool;
+  double flops;
+  std::vector<fptype> y;
+  std::vector<RowBucketStats> buckets;
+};
+
+/* Row lengths are distributed log uniformly between 1 and
+ * 2^maxLogLength, so most rows are short and a few are
+ * very long
+ */
+template <typename fptype>
+CSRMatrix<fptype> randomCSRMatrix(std::mt19937_64 &rgen,
+                                  unsigned rows,
+                                  unsigned cols,
+                                  unsigned maxLogLength) {
+  std::uniform_real_distribution<double> logLength(
+      0.0, maxLogLength);
+  std::uniform_int_distribution<unsigned> column(0,
+                                                 cols - 1);
+  std::uniform_real_distribution<fptype> value(-1.0, 1.0);
+  std::vector<std::pair<unsigned, unsigned>> pos;
+  std::vector<fptype> vals;
+  for(unsigned r = 0; r < rows; r++) {
+    const unsigned length = std::exp2(logLength(rgen));
+    for(unsigned i = 0; i < length; i++) {
+      pos.push_back({r, column(rgen)});
+      vals.push_back(value(rgen));
+    }
+  }
+  return buildCSR(rows, cols, pos, vals);
+}
+
+template <typename fptype>
+void runTests(std::mt19937_64 &engine,
+              const CSRMatrix<fptype> &matrix,
+              const int numTests,
+              const unsigned numThreads) {
+  NumericTester::NumericTest *tests[] = {
+      new SpMVTest<fptype, NaiveRow>(numThreads),
+      new SpMVTest<fptype, FMARow>(numThreads),
+      new SpMVTest<fptype, KahanRow>(numThreads),
+      new SpMVTest<fptype, Dot2Row>(numThreads)};
+  std::uniform_real_distribution<fptype> rgenf(-1.0, 1.0);
+  for(int i = 0; i < numTests; i++) {
+    SpMVCase<fptype> testcase(engine, rgenf, matrix);
+    for(auto t : tests) t->updateStats(testcase);
+  }
+  for(auto t : tests) {
+    t->printStats();
+    std::cout << "\n\n";
+    std::string fname = t->testName().append(".csv");
+    std::ofstream results(fname, std::ios::out);
+    t->dumpData(results);
+    delete t;
+  }
+}
+
+template <typename fptype>
+void runTests(std::mt19937_64 &engine, const int numTests,
+              const unsigned numThreads,
+              const std::string &fname) {
+  constexpr const unsigned randomSize = 4096;
+  constexpr const unsigned randomMaxLogLength = 11;
+  CSRMatrix<fptype> matrix =
+      fname.empty()
+          ? randomCSRMatrix<fptype>(engine, randomSize,
+                                    randomSize,
+                                    randomMaxLogLength)
+          : readMatrixMarket<fptype>(fname);
+  runTests(engine, matrix, numTests, numThreads);
+}
+
+/* Without a MatrixMarket file, a random matrix with
+ * uneven row lengths is used
+ */
+int main(int argc, char **argv) {
+  int numTests = 16;
+  const unsigned cores =
+      std::thread::hardware_concurrency();
+  int numThreads = std::max(1u, std::min(4u, cores));
+  std::string fname;
+  if(argc > 1) {
+    numTests = atoi(argv[1]);
+    if(numTests < 1) {
+      printf("Number of tests must be greater than 0\n");
+      return -1;
+    }
+    if(argc > 2) {
+      numThreads = atoi(argv[2]);
+      if(numThreads < 1) {
+        printf(
+            "Number of threads must be greater than 0\n");
+        return -1;
+      }
+      if(argc > 3) fname = argv[3];
+    }
+  }
+  mpfr::mpreal::set_default_prec(statBits);
+  std::random_device rd;
+  std::mt19937_64 engine(rd());
+  try {
+    runTests<float>(engine, numTests, numThreads, fname);
+    runTests<double>(engine, numTests, numThreads, fname);
+  } catch(MatrixMarketError &) {
+    printf("Could not read the MatrixMarket file %s\n",
+           fname.c_str());
+    return -1;
+  }
+  return 0;
+}
@@ -2,6 +2,24 @@
 #include <gtest/gtest.h>
 
 #include "numerictester.hpp"
+#include "accurate_math.hpp"
+#include "faithful_sum.hpp"
+#include "binned_sum.hpp"
+#include "sorted_sum.hpp"
+#include "ozaki.hpp"
+#include "gemm.hpp"
+#include "horner.hpp"
+#include "quadratic.hpp"
+#include "general_quadric.hpp"
+#include "ray_quadric.hpp"
+#include "predicates.hpp"
+#include "interval.hpp"
+#include "quadric_batch.hpp"
+#include "fixed_dim.hpp"
+#include "case_arena.hpp"
+#include "mp_allocator.hpp"
+#include "fixed_mp.hpp"
+#include "reference_cache.hpp"
 
 template <typename fptype>
 class NTest;
@@ -19,6 +37,9 @@ class NTestCase : public NumericTester::TestCase {
 template <typename fptype>
 class NTest : public NumericTester::NumericTest {
  public:
+  NTest(bool signMode = false)
+      : NumericTester::NumericTest(signMode) {}
+
   virtual std::string testName() {
     return std::string("Null Test");
   }
@@ -31,7 +52,11 @@ class NTest : public NumericTester::NumericTest {
         static_cast<const NTestCase<fptype> *>(&testCase);
     startTimer();
     stopTimer();
-    addStatistic(test->estimate, test->correctValue());
+    if(signMode)
+      addSignStatistic(test->estimate, test->correctValue(),
+                       mpfr::abs(test->correctValue()));
+    else
+      addStatistic(test->estimate, test->correctValue());
   }
 };
 
@@ -100,6 +125,908 @@ TEST(Statistics, extremevals) {
             known[numTests - 1]);
 }
 
+TEST(Statistics, signs) {
+  constexpr const float cases[][2] = {
+      {1.0, 2.0},     {-1.0, -0.5}, {0.25, -0.25},
+      {-0.25, 0.25},  {0.0, 1.0},   {0.0, 0.0},
+      {0.125, 0.0},   {1.0, NAN}};
+  NTest<float> test(true);
+  for(auto &c : cases) {
+    NTestCase<float> testcase(c[0], c[1]);
+    test.updateStats(testcase);
+  }
+  EXPECT_EQ(test.wrongSignCount(), 3);
+  EXPECT_EQ(test.zeroAsNonzeroCount(), 1);
+  EXPECT_EQ(test.nonzeroAsZeroCount(), 1);
+  const auto &hist = test.misclassifiedByDistance();
+  constexpr const int minExp =
+      NumericTester::NumericTest::minSignExp;
+  EXPECT_EQ(hist[0], 1);
+  EXPECT_EQ(hist[-2 - minExp], 2);
+  EXPECT_EQ(hist[-3 - minExp], 1);
+  EXPECT_EQ(hist[0 - minExp], 1);
+}
+
+template <typename fptype>
+class NTestBlock : public NumericTester::CaseBlock {
+ public:
+  virtual unsigned size() const { return cases.size(); }
+  virtual const NTestCase<fptype> &operator[](
+      unsigned i) const {
+    return cases[i];
+  }
+  std::vector<NTestCase<fptype>> cases;
+};
+
+/* By default a block updates the statistics like its
+ * cases in order
+ */
+TEST(Statistics, batch) {
+  NTest<float> single, batched;
+  NTestBlock<float> block;
+  for(unsigned i = 0; i < 5; i++) {
+    NTestCase<float> testcase(1.0, 1.0 + 0.25 * i);
+    single.updateStats(testcase);
+    block.cases.push_back(testcase);
+  }
+  batched.updateStatsBatch(block);
+  EXPECT_EQ(batched.calcRelErrorAvg(),
+            single.calcRelErrorAvg());
+  EXPECT_EQ(batched.calcRelErrorMax(),
+            single.calcRelErrorMax());
+}
+
+/* A summand larger than the running sum defeats Kahan's
+ * compensation, but not Neumaier's or Klein's
+ */
+TEST(Summation, largeSummand) {
+  constexpr const double summands[] = {1.0, 1e100, 1.0,
+                                       -1e100};
+  constexpr const unsigned size =
+      sizeof(summands) / sizeof(summands[0]);
+  EXPECT_EQ(kahanSum(summands, size), 0.0);
+  EXPECT_EQ(neumaierSum(summands, size), 2.0);
+  EXPECT_EQ(kleinSum(summands, size), 2.0);
+  EXPECT_EQ(neumaierSumSIMD(summands, size), 2.0);
+  EXPECT_EQ(kleinSumSIMD(summands, size), 2.0);
+}
+
+/* The naive kernels must round the product before adding,
+ * which the build ensures with -ffp-contract=off; when
+ * contracted into an FMA this gives -2^-60 instead
+ */
+TEST(Summation, uncontracted) {
+  volatile double a = 1.0 + std::ldexp(1.0, -30);
+  volatile double b = 1.0 - std::ldexp(1.0, -30);
+  volatile double c = -1.0;
+  const double x = a, y = b, z = c;
+  EXPECT_EQ(x * y + z, 0.0);
+  EXPECT_EQ(std::fma(x, y, z), -std::ldexp(1.0, -60));
+}
+
+TEST(Summation, secondOrder) {
+  /* The first order compensation of these rounds away
+   * the low bits of the two tiny summands
+   */
+  const double summands[] = {-5.0 * std::ldexp(1.0, -53),
+                             -3.0 * std::ldexp(1.0, -107),
+                             -5.0,
+                             -5.0 * std::ldexp(1.0, -106),
+                             5.0};
+  constexpr const unsigned size =
+      sizeof(summands) / sizeof(summands[0]);
+  const double exact = std::nextafter(summands[0], -1.0);
+  EXPECT_NE(neumaierSum(summands, size), exact);
+  EXPECT_EQ(kleinSum(summands, size), exact);
+}
+
+/* The exact sum is just above the midpoint of 1 and its
+ * successor, so it must round up, though the naive sum and
+ * the cancelling terms both push it down to 1
+ */
+TEST(Summation, correctRounding) {
+  const double halfUlp = std::ldexp(1.0, -53);
+  const double summands[] = {1e100, 1.0,     -1e100,
+                             halfUlp, halfUlp * halfUlp};
+  constexpr const unsigned size =
+      sizeof(summands) / sizeof(summands[0]);
+  const double rounded = std::nextafter(1.0, 2.0);
+  double scratch[size];
+  std::copy(summands, summands + size, scratch);
+  double faithful = accSum(scratch, size);
+  EXPECT_TRUE(faithful == 1.0 || faithful == rounded);
+  std::copy(summands, summands + size, scratch);
+  faithful = fastAccSum(scratch, size);
+  EXPECT_TRUE(faithful == 1.0 || faithful == rounded);
+  std::copy(summands, summands + size, scratch);
+  EXPECT_EQ(iFastSum(scratch, size), rounded);
+  OnlineExactSum<double> online;
+  for(double val : summands) online.add(val);
+  EXPECT_EQ(online.result(), rounded);
+}
+
+/* Too many float summands for AccSum's and FastAccSum's
+ * error-free extraction, which must still sum faithfully;
+ * the exact sum is a float, so it's the only faithful one
+ */
+TEST(Summation, longFaithful) {
+  constexpr const unsigned size = 4098;
+  std::vector<float> summands;
+  for(unsigned i = 0; i < (size - 2) / 2; i++) {
+    summands.push_back((i + 1) * 1024.0f);
+    summands.push_back(-1024.0f * (i + 1));
+  }
+  summands.push_back(3.0f);
+  summands.push_back(std::ldexp(1.0f, -20));
+  const float exact = 3.0f + std::ldexp(1.0f, -20);
+  std::vector<float> scratch(summands);
+  EXPECT_EQ(accSum(scratch.data(), size), exact);
+  scratch = summands;
+  EXPECT_EQ(fastAccSum(scratch.data(), size), exact);
+}
+
+/* The naive sum of these depends on the order,
+ * the binned sum must not, nor on how it is split
+ */
+TEST(Summation, binnedReproducible) {
+  const double halfUlp = std::ldexp(1.0, -53);
+  const double summands[] = {1e100, 1.0, -1e100, halfUlp,
+                             halfUlp * halfUlp};
+  constexpr const unsigned size =
+      sizeof(summands) / sizeof(summands[0]);
+  const double rounded = std::nextafter(1.0, 2.0);
+  BinnedSum<double> forward, backward;
+  for(unsigned i = 0; i < size; i++) {
+    forward.deposit(summands[i]);
+    backward.deposit(summands[size - 1 - i]);
+  }
+  EXPECT_EQ(forward.result(), rounded);
+  EXPECT_EQ(backward.result(), rounded);
+  BinnedSum<double> low, high;
+  low.deposit(summands[1]);
+  low.deposit(summands[3]);
+  high.deposit(summands[0]);
+  high.deposit(summands[2]);
+  high.deposit(summands[4]);
+  low.merge(high);
+  EXPECT_EQ(low.result(), rounded);
+}
+
+/* A pool is reused for several tasks, and the binned dot
+ * product doesn't depend on how many threads split it
+ */
+TEST(WorkerPool, reusedForBinnedDotProd) {
+  constexpr const unsigned dim = 1000;
+  std::vector<double> v1(dim), v2(dim);
+  for(unsigned i = 0; i < dim; i++) {
+    v1[i] = std::ldexp(1.0 + i, int(i * 37 % 200) - 100);
+    v2[i] = i % 2 ? 1.0 : -1.0 / 3.0;
+  }
+  const double serial =
+      binnedDotProd(v1.data(), v2.data(), dim);
+  WorkerPool pool(4);
+  for(unsigned rep = 0; rep < 8; rep++) {
+    std::vector<unsigned> ran(pool.size(), 0);
+    pool.run([&ran](unsigned t) { ran[t]++; });
+    EXPECT_EQ(ran, std::vector<unsigned>(pool.size(), 1));
+    EXPECT_EQ(binnedDotProdParallel(v1.data(), v2.data(),
+                                    dim, pool),
+              serial);
+  }
+}
+
+/* Checks radixSort against a stable sort by magnitude,
+ * comparing bits so the signs of zeros count
+ */
+template <typename fptype, typename order>
+void expectSorted(std::vector<fptype> vals,
+                  bool increasing) {
+  std::vector<fptype> expected(vals);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [increasing](fptype lhs, fptype rhs) {
+                     return increasing
+                                ? std::fabs(lhs) <
+                                      std::fabs(rhs)
+                                : std::fabs(lhs) >
+                                      std::fabs(rhs);
+                   });
+  std::vector<fptype> scratch(vals.size());
+  radixSort<fptype, order>(vals.data(), scratch.data(),
+                           vals.size());
+  for(unsigned i = 0; i < vals.size(); i++)
+    EXPECT_EQ(fpBits(vals[i]), fpBits(expected[i]));
+}
+
+template <typename fptype>
+void expectMagnitudeSorted(
+    const std::vector<fptype> &vals) {
+  using increasing = IncreasingMagnitude<fptype>;
+  using decreasing = DecreasingMagnitude<fptype>;
+  expectSorted<fptype, increasing>(vals, true);
+  expectSorted<fptype, decreasing>(vals, false);
+}
+
+TEST(RadixSort, magnitudeOrders) {
+  const std::vector<double> mixed = {
+      3.0, -0.0,   -1.5,   0.0,  1.5, -3.0,
+      2.0, 2.0, 1e-300, -1e300, -2.0, 0.0};
+  expectMagnitudeSorted(mixed);
+  expectMagnitudeSorted(std::vector<float>(
+      mixed.begin(), mixed.begin() + 8));
+  std::vector<double> sorted;
+  for(unsigned i = 0; i < 300; i++)
+    sorted.push_back(std::ldexp(1.0 + i, i / 3));
+  expectMagnitudeSorted(sorted);
+  expectMagnitudeSorted(std::vector<float>(64, -0.25f));
+  expectMagnitudeSorted(std::vector<double>{-0.0, 0.0});
+}
+
+/* The first row sums to just over the midpoint of 1 and
+ * its successor, which every naive order rounds to 1.
+ * Each column of the product scales its row sum by 1 or 2
+ */
+TEST(Ozaki, gemmMatchesDotProd) {
+  const double overHalfUlp = 1.5 * std::ldexp(1.0, -53);
+  const double a[] = {1e100, 1.0,  -1e100, overHalfUlp,
+                      3.0,   -1.0, 1e-3,   2.0};
+  const double b[] = {1.0, 2.0, 1.0, 2.0,
+                      1.0, 2.0, 1.0, 2.0};
+  double c[4];
+  OzakiScheme<double> ozaki(4);
+  ozaki.gemm(a, b, c, 2, 2, 4);
+  EXPECT_EQ(c[0], std::nextafter(1.0, 2.0));
+  EXPECT_EQ(c[1], 2 * c[0]);
+  const double column[] = {1.0, 1.0, 1.0, 1.0};
+  EXPECT_EQ(c[2], ozaki.dotProd(a + 4, column, 4));
+  EXPECT_EQ(c[3], 2 * c[2]);
+}
+
+/* Rows with heavy cancellation, which the compensated
+ * GEMV must get within an ulp of the MPFR reference, for
+ * any blocking of the inner dimension
+ */
+TEST(GEMV, compensatedMatchesReference) {
+  constexpr const unsigned rows = 6, inner = 37;
+  double a[rows * inner], x[inner];
+  for(unsigned k = 0; k < inner; k++)
+    x[k] = 1.0 / (k + 1);
+  for(unsigned i = 0; i < rows; i++) {
+    for(unsigned k = 0; k < inner; k++) {
+      const int mantissa = int((k * 7 + i) % 11) - 5;
+      const int exp = int((k * 13 + i * 5) % 60) - 30;
+      a[i * inner + k] = std::ldexp(mantissa, exp);
+    }
+    /* Cancels most of the row */
+    a[i * inner] = 1e30;
+    a[i * inner + inner - 1] = -1e30 * inner;
+  }
+  double y[rows];
+  compensatedGEMV(a, x, y, rows, inner);
+  for(unsigned i = 0; i < rows; i++) {
+    mpfr::mpreal exact(0.0, 4096);
+    for(unsigned k = 0; k < inner; k++) {
+      exact += mpfr::mpreal(a[i * inner + k], 4096) *
+               mpfr::mpreal(x[k], 4096);
+    }
+    const double rounded = exact.toDouble();
+    EXPECT_LE(std::fabs(y[i] - rounded),
+              std::nextafter(std::fabs(rounded), 2e300) -
+                  std::fabs(rounded));
+  }
+  for(unsigned kBlock : {1u, 4u, 16u}) {
+    double blocked[rows];
+    compensatedGEMV(a, x, blocked, rows, inner, kBlock);
+    for(unsigned i = 0; i < rows; i++)
+      EXPECT_EQ(blocked[i], y[i]);
+  }
+}
+
+/* (x - 1)^3 is 2^-60 at x = 1 + 2^-20, but its expanded
+ * form cancels every bit of Horner's scheme.
+ * The condition number is near 2^63, so CompHorner is only
+ * accurate to about 2^-40, while 3 fold Horner is exact
+ */
+TEST(Horner, compensatedNearRoot) {
+  const double coeffs[] = {-1.0, 3.0, -3.0, 1.0};
+  const double x = 1.0 + std::ldexp(1.0, -20);
+  const double exact = std::ldexp(1.0, -60);
+  EXPECT_NE(horner(coeffs, 3, x), exact);
+  EXPECT_NEAR(compHorner(coeffs, 3, x), exact,
+              exact * std::ldexp(1.0, -36));
+  KFoldHorner<double> kFold(3);
+  EXPECT_EQ(kFold.evaluate(coeffs, 3, x), exact);
+  double points[] = {x, x, x};
+  double results[3];
+  compHornerSIMD(coeffs, 3, points, results, 3);
+  for(double val : results)
+    EXPECT_EQ(val, compHorner(coeffs, 3, x));
+}
+
+/* The second set has complex roots, but its rounded
+ * discriminant is exactly 0.
+ * The first set's roots, 1 and 2, are exact for every
+ * solver
+ */
+TEST(Quadratic, discriminantSign) {
+  const double a[] = {1.0, 0.7721146126479759};
+  const double b[] = {-3.0, -0.9558505785189516};
+  const double c[] = {2.0, 0.29582730124794565};
+  double disc[2], low[2], high[2];
+  solveQuadratics<NaiveQuadratic>(a, b, c, disc, low, high,
+                                  2);
+  EXPECT_EQ(disc[1], 0.0);
+  solveQuadratics<KahanQuadratic>(a, b, c, disc, low, high,
+                                  2);
+  EXPECT_LT(disc[1], 0.0);
+  EXPECT_EQ(low[0], 1.0);
+  EXPECT_EQ(high[0], 2.0);
+  solveQuadratics<DoubleDoubleQuadratic>(a, b, c, disc, low,
+                                         high, 2);
+  EXPECT_LT(disc[1], 0.0);
+  EXPECT_EQ(low[0], 1.0);
+  EXPECT_EQ(high[0], 2.0);
+}
+
+TEST(GeneralQuadric, errorFreeNearSurface) {
+  /* The unit sphere about (1, 0, 0) */
+  const double m[4][4] = {{1.0, 0.0, 0.0, -1.0},
+                          {0.0, 1.0, 0.0, 0.0},
+                          {0.0, 0.0, 1.0, 0.0},
+                          {-1.0, 0.0, 0.0, 0.0}};
+  GeneralQuadric<double> sphere =
+      GeneralQuadric<double>::fromMatrix(m);
+  EXPECT_EQ(sphere.coeffs[GeneralQuadric<double>::x], -2.0);
+  const double x[] = {2.0 + std::ldexp(1.0, -30), 2.0,
+                      0.0};
+  const double y[] = {std::ldexp(1.0, -20), 0.0, 0.0};
+  const double z[] = {0.0, 0.0, 0.0};
+  double values[3];
+  evaluateQuadric<ExactQuadricKernel>(sphere, x, y, z,
+                                      values, 3);
+  EXPECT_EQ(values[0], std::ldexp(1.0, -29) +
+                           std::ldexp(1.0, -40) +
+                           std::ldexp(1.0, -60));
+  EXPECT_EQ(values[1], 0.0);
+  EXPECT_EQ(values[2], 0.0);
+}
+
+/* The distance from val to the double nearest exact,
+ * in ulps of that double
+ */
+double ulpError(double val, const mpfr::mpreal &exact) {
+  const double rounded = exact.toDouble();
+  const double ulp =
+      std::nextafter(std::fabs(rounded), INFINITY) -
+      std::fabs(rounded);
+  return std::fabs(val - rounded) / ulp;
+}
+
+/* A rotated hyperboloid, near its center, where every
+ * partial derivative is 10^5 times smaller than its terms.
+ * The points fill a vector and a partial one
+ */
+TEST(GeneralQuadric, compensatedGradient) {
+  const double affine[3][3] = {{0.8, 0.3, -0.1},
+                               {-0.2, 0.9, 0.4},
+                               {0.5, -0.1, 0.7}};
+  const double diag[4] = {1.0, 2.0, -1.0, -9.0};
+  const double center[3] = {1000.3, -2000.7, 1500.1};
+  /* H = [A t; 0 1] with t = -A center, and M = H^T D H */
+  double h[4][4] = {};
+  for(unsigned i = 0; i < 3; i++) {
+    for(unsigned j = 0; j < 3; j++) {
+      h[i][j] = affine[i][j];
+      h[i][3] -= affine[i][j] * center[j];
+    }
+  }
+  h[3][3] = 1.0;
+  double m[4][4];
+  for(unsigned i = 0; i < 4; i++) {
+    for(unsigned j = 0; j < 4; j++) {
+      m[i][j] = 0.0;
+      for(unsigned k = 0; k < 4; k++)
+        m[i][j] += h[k][i] * diag[k] * h[k][j];
+    }
+  }
+  const GeneralQuadric<double> quadric =
+      GeneralQuadric<double>::fromMatrix(m);
+  using vec = SIMD::Vector<double>::type;
+  constexpr const unsigned lanes =
+      SIMD::Vector<double>::lanes;
+  constexpr const unsigned count = lanes + 3;
+  double pts[3][count];
+  for(unsigned p = 0; p < count; p++) {
+    for(unsigned i = 0; i < 3; i++)
+      pts[i][p] = center[i] + 1e-3 * (p + 1) * (i + 1);
+  }
+  double normals[3][count];
+  quadricNormals<CompensatedGradientKernel>(
+      quadric, pts[0], pts[1], pts[2], normals[0],
+      normals[1], normals[2], count);
+  for(unsigned j = 0; j < count; j += lanes) {
+    const unsigned width = std::min(lanes, count - j);
+    vec compensated[3], naive[3];
+    const vec x = SIMD::loadPartial(pts[0] + j, width);
+    const vec y = SIMD::loadPartial(pts[1] + j, width);
+    const vec z = SIMD::loadPartial(pts[2] + j, width);
+    CompensatedGradientKernel::gradient<double>(
+        quadric, x, y, z, compensated);
+    NaiveGradientKernel::gradient<double>(quadric, x, y, z,
+                                          naive);
+    for(unsigned p = j; p < j + width; p++) {
+      mpfr::mpreal exact[3], length(0.0, 1024);
+      for(unsigned i = 0; i < 3; i++) {
+        const std::array<double, 4> row =
+            quadric.gradientRow(i);
+        exact[i] = mpfr::mpreal(row[3], 1024);
+        for(unsigned k = 0; k < 3; k++) {
+          exact[i] +=
+              mpfr::mpreal(row[k], 1024) * pts[k][p];
+        }
+        length += exact[i] * exact[i];
+      }
+      length = mpfr::sqrt(length);
+      double naiveError = 0.0;
+      for(unsigned i = 0; i < 3; i++) {
+        EXPECT_LE(ulpError(compensated[i][p - j], exact[i]),
+                  1.0);
+        naiveError =
+            std::max(naiveError,
+                     ulpError(naive[i][p - j], exact[i]));
+        /* The normalization adds a few roundings */
+        EXPECT_LE(
+            ulpError(normals[i][p], exact[i] / length),
+            4.0);
+      }
+      EXPECT_GT(naiveError, 1e3);
+    }
+  }
+}
+
+/* Kettner et al.'s example: a point on a grid of ulps
+ * near the line through (12, 12) and (24, 24), where the
+ * sign of orient2d is the sign of y - x
+ */
+TEST(Predicates, orient2dNearLine) {
+  const double ulp = std::ldexp(1.0, -53);
+  unsigned filterErrors = 0;
+  for(int i = 0; i < 16; i++) {
+    for(int j = 0; j < 16; j++) {
+      const double pts[] = {0.5 + i * ulp, 0.5 + j * ulp,
+                            12.0, 12.0, 24.0, 24.0};
+      const int sign = (j > i) - (j < i);
+      PredicateStage stage;
+      const double det =
+          adaptivePredicate<Orient2d>(pts, stage);
+      EXPECT_EQ((det > 0) - (det < 0), sign);
+      const double exact = exactPredicate<Orient2d>(pts);
+      EXPECT_EQ((exact > 0) - (exact < 0), sign);
+      double permanent;
+      const double fast = Orient2d::fast(pts, permanent);
+      if((fast > 0) - (fast < 0) != sign) filterErrors++;
+    }
+  }
+  EXPECT_GT(filterErrors, 0);
+}
+
+/* 0.1 isn't representable, so every product is rounded,
+ * and the enclosure of the sum must be a nonempty interval
+ * around the exact value
+ */
+TEST(Interval, enclosesDotProduct) {
+  constexpr const unsigned dim = 37;
+  float v1[dim], v2[dim];
+  mpfr::mpreal exact(0.0);
+  for(unsigned i = 0; i < dim; i++) {
+    v1[i] = 0.1f * (i + 1);
+    v2[i] = (i % 2 == 0) ? 0.1f : -0.1f;
+    exact += mpfr::mpreal(v1[i]) * mpfr::mpreal(v2[i]);
+  }
+  Interval<float> sum;
+  {
+    UpwardRounding rounding;
+    sum = intervalDotProd(v1, v2, dim);
+  }
+  EXPECT_LT(sum.lower(), sum.upper());
+  EXPECT_LE(mpfr::mpreal(sum.lower()), exact);
+  EXPECT_GE(mpfr::mpreal(sum.upper()), exact);
+  EXPECT_EQ(certifiedSign(sum), 1);
+  EXPECT_EQ(certifiedSign(sum - sum), 0);
+}
+
+/* The batch size isn't a multiple of the vector width,
+ * so the last cases are evaluated in a partial vector
+ */
+TEST(QuadricBatch, matchesScalar) {
+  constexpr const unsigned size = 37;
+  QuadricBatch<double> batch(size);
+  for(unsigned c = 0; c < size; c++) {
+    for(unsigned i = 0; i < batch.dim; i++) {
+      batch.pos[i][c] = 0.1 * (c + i);
+      batch.trans[i][c] = -0.3 * i + c;
+    }
+    batch.radius[c] = 0.7 * c;
+  }
+  double values[size];
+  evaluateQuadrics<FMABatchKernel>(batch, values);
+  for(unsigned c = 0; c < size; c++) {
+    double moddedPt[batch.dim];
+    double transSum = -batch.radius[c] * batch.radius[c];
+    for(unsigned i = 0; i < batch.dim; i++) {
+      const double pos = batch.pos[i][c];
+      const double trans = batch.trans[i][c];
+      moddedPt[i] = pos + trans;
+      transSum = std::fma(pos, trans, transSum);
+      transSum = std::fma(trans, trans, transSum);
+    }
+    for(unsigned i = 0; i < batch.dim; i++)
+      transSum =
+          std::fma(batch.pos[i][c], moddedPt[i], transSum);
+    EXPECT_EQ(values[c], transSum);
+  }
+}
+
+/* Points within a few ulps of spheres, where the naive
+ * evaluation cancels to noise, and the exactly rounded
+ * value must still be the nearest to the exact one
+ */
+template <typename fptype>
+void testCorrectlyRoundedQuadric() {
+  constexpr const unsigned dim = QuadricBatch<fptype>::dim;
+  constexpr const unsigned numCases = 200;
+  constexpr const mpfr_prec_t prec = 1024;
+  for(unsigned c = 0; c < numCases; c++) {
+    const fptype radius = fptype(1000.5 + 13.25 * c);
+    const double theta = 0.1 + 0.37 * c;
+    const double phi = 0.2 + 1.13 * c;
+    const double dir[dim] = {
+        std::cos(theta), std::sin(theta) * std::cos(phi),
+        std::sin(theta) * std::sin(phi)};
+    fptype pos[dim], trans[dim];
+    for(unsigned i = 0; i < dim; i++) {
+      trans[i] = fptype(123.25 * (i + 1) - 7.5 * c);
+      pos[i] = fptype(dir[i] * radius - trans[i]);
+    }
+    mpfr::mpreal exact = -mpfr::mpreal(radius, prec) *
+                         mpfr::mpreal(radius, prec);
+    for(unsigned i = 0; i < dim; i++) {
+      const mpfr::mpreal modded =
+          mpfr::mpreal(pos[i], prec) +
+          mpfr::mpreal(trans[i], prec);
+      exact += modded * modded;
+    }
+    const fptype value =
+        correctlyRoundedQuadric(pos, trans, radius);
+    EXPECT_EQ(value, static_cast<fptype>(exact));
+  }
+}
+
+TEST(QuadricBatch, correctlyRounded) {
+  testCorrectlyRoundedQuadric<float>();
+  testCorrectlyRoundedQuadric<double>();
+}
+
+/* The scalar nearestHit of ray_quadric.hpp */
+template <typename fptype>
+fptype scalarNearestHit(fptype disc, fptype t1, fptype t2) {
+  const fptype tNear = std::min(t1, t2);
+  const fptype tFar = std::max(t1, t2);
+  if(!(disc >= 0) || !(tFar > 0))
+    return std::numeric_limits<fptype>::infinity();
+  return tNear > 0 ? tNear : tFar;
+}
+
+/* Rays grazing a sphere at radius * (1 +- 2^-k) from its
+ * center, for k up to 30, from origins 3 radii away
+ */
+RayPacket<float> grazingRays(
+    const RayQuadric<float> &sphere, unsigned count) {
+  RayPacket<float> rays(count);
+  for(unsigned r = 0; r < count; r++) {
+    const double theta = 0.1 + 0.37 * r;
+    const double phi = 0.2 + 1.13 * r;
+    const double dir[3] = {std::cos(theta),
+                           std::sin(theta) * std::cos(phi),
+                           std::sin(theta) * std::sin(phi)};
+    /* dir x (0, 0, 1), normalized */
+    const double perpNorm = std::hypot(dir[0], dir[1]);
+    const double perp[3] = {dir[1] / perpNorm,
+                            -dir[0] / perpNorm, 0.0};
+    const double sign = r % 2 == 0 ? 1.0 : -1.0;
+    const double offset =
+        sphere.radius *
+        (1.0 + sign * std::ldexp(1.0, -int(r % 31)));
+    for(unsigned i = 0; i < 3; i++) {
+      const double target =
+          -sphere.trans[i] + perp[i] * offset;
+      rays.origin[i][r] =
+          target - dir[i] * 3.0 * sphere.radius;
+      rays.dir[i][r] = dir[i];
+    }
+  }
+  return rays;
+}
+
+RayQuadric<float> testSphere() {
+  RayQuadric<float> sphere;
+  const float trans[3] = {123.25f, -77.5f, 42.0f};
+  for(unsigned i = 0; i < 3; i++) {
+    sphere.trans[i] = trans[i];
+    sphere.weight[i] = 1.0f;
+  }
+  sphere.radius = 1000.5f;
+  return sphere;
+}
+
+/* The packet isn't a multiple of the vector width, so the
+ * last rays are intersected in a partial vector.
+ * The naive and FMA kernels match the same operations on
+ * scalars, which checks the square root and FMA
+ * intrinsics lane by lane, and every kernel gives a ray
+ * the same distance alone as in the packet
+ */
+TEST(RayQuadric, matchesScalar) {
+  const RayQuadric<float> sphere = testSphere();
+  const unsigned count =
+      3 * SIMD::Vector<float>::lanes + 5;
+  const RayPacket<float> rays = grazingRays(sphere, count);
+  std::vector<float> naive(count), fma(count),
+      compensated(count);
+  intersectRays<NaiveRayKernel>(sphere, rays, naive.data());
+  intersectRays<FMARayKernel>(sphere, rays, fma.data());
+  intersectRays<CompensatedRayKernel>(sphere, rays,
+                                      compensated.data());
+  for(unsigned r = 0; r < count; r++) {
+    float a = 0.0f, h = 0.0f;
+    float c = 0.0f - sphere.radius * sphere.radius;
+    float aFMA = 0.0f, hFMA = 0.0f, cFMA = c;
+    for(unsigned i = 0; i < 3; i++) {
+      const float d = rays.dir[i][r];
+      const float oc = rays.origin[i][r] + sphere.trans[i];
+      a += d * d;
+      h += d * oc;
+      c += oc * oc;
+      aFMA = std::fma(d, d, aFMA);
+      hFMA = std::fma(d, oc, hFMA);
+      cFMA = std::fma(oc, oc, cFMA);
+    }
+    const float disc = h * h - a * c;
+    const float sqrtDisc = std::sqrt(disc);
+    EXPECT_EQ(naive[r],
+              scalarNearestHit(disc, (-h - sqrtDisc) / a,
+                               (-h + sqrtDisc) / a));
+    const float discFMA =
+        std::fma(hFMA, hFMA, -(aFMA * cFMA));
+    const float sqrtFMA = std::sqrt(discFMA);
+    const float q =
+        -(hFMA + (hFMA < 0 ? -sqrtFMA : sqrtFMA));
+    EXPECT_EQ(fma[r], scalarNearestHit(discFMA, q / aFMA,
+                                       cFMA / q));
+    RayPacket<float> alone(1);
+    for(unsigned i = 0; i < 3; i++) {
+      alone.origin[i][0] = rays.origin[i][r];
+      alone.dir[i][0] = rays.dir[i][r];
+    }
+    float dist;
+    intersectRays<CompensatedRayKernel>(sphere, alone,
+                                        &dist);
+    EXPECT_EQ(compensated[r], dist);
+  }
+}
+
+/* The compensated kernel classifies every grazing ray as
+ * the exact discriminant does, where the naive kernel's
+ * cancellation misclassifies some
+ */
+TEST(RayQuadric, compensatedGrazing) {
+  const RayQuadric<float> sphere = testSphere();
+  constexpr const unsigned count = 31 * 16;
+  const RayPacket<float> rays = grazingRays(sphere, count);
+  std::vector<float> naive(count), compensated(count);
+  intersectRays<NaiveRayKernel>(sphere, rays, naive.data());
+  intersectRays<CompensatedRayKernel>(sphere, rays,
+                                      compensated.data());
+  unsigned naiveErrors = 0, compensatedErrors = 0;
+  for(unsigned r = 0; r < count; r++) {
+    mpfr::mpreal a(0.0, 1024), h(0.0, 1024);
+    mpfr::mpreal c(sphere.radius, 1024);
+    c *= -c;
+    for(unsigned i = 0; i < 3; i++) {
+      const mpfr::mpreal d(rays.dir[i][r], 1024);
+      mpfr::mpreal oc(rays.origin[i][r], 1024);
+      oc += sphere.trans[i];
+      a += d * d;
+      h += d * oc;
+      c += oc * oc;
+    }
+    /* The origins are outside, before the sphere */
+    const bool hit = h * h - a * c >= 0;
+    if(std::isinf(naive[r]) == hit) naiveErrors++;
+    if(std::isinf(compensated[r]) == hit)
+      compensatedErrors++;
+  }
+  EXPECT_GT(naiveErrors, 0);
+  EXPECT_EQ(compensatedErrors, 0);
+}
+
+/* The specializations sum in the generic loop's order */
+TEST(FixedDim, matchesGeneric) {
+  double v1[17], v2[17];
+  for(unsigned i = 0; i < 17; i++) {
+    v1[i] = 0.1 * (i + 1);
+    v2[i] = 1.0 / (i + 3);
+  }
+  for(unsigned dim = 1; dim <= 17; dim++) {
+    EXPECT_EQ(
+        fixedDimDotProd<KahanFMADotKernel>(v1, v2, dim),
+        KahanFMADotKernel::dotProd<0>(v1, v2, dim));
+    EXPECT_EQ(fixedDimDotProd<NaiveDotKernel>(v1, v2, dim),
+              NaiveDotKernel::dotProd<0>(v1, v2, dim));
+  }
+}
+
+/* After a reset the same allocations map nothing more */
+TEST(CaseArena, reusesChunks) {
+  CaseArena arena(false);
+  for(unsigned pass = 0; pass < 3; pass++) {
+    arena.reset();
+    for(unsigned i = 1; i < 100; i++) {
+      double *vec = arena.allocate<double>(i * 37);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(vec) %
+                    CaseArena::alignment,
+                0);
+      vec[i * 37 - 1] = i;
+    }
+  }
+  const auto &stats = arena.statistics();
+  EXPECT_EQ(stats.allocations, 3 * 99);
+  EXPECT_EQ(stats.resets, 3);
+  const unsigned long mappings = stats.mappings;
+  arena.reset();
+  arena.allocate<double>(99 * 37);
+  EXPECT_EQ(arena.statistics().mappings, mappings);
+  EXPECT_GE(stats.bytesMapped, stats.peakBytesInUse);
+}
+
+/* Freed blocks are reused by their size class,
+ * and contents survive moving to another class
+ */
+TEST(MPAllocator, reusesBlocks) {
+  void *block = MPAllocator::allocate(100);
+  MPAllocator::deallocate(block, 100);
+  EXPECT_EQ(MPAllocator::allocate(110), block);
+  EXPECT_EQ(MPAllocator::reallocate(block, 110, 112),
+            block);
+  std::memset(block, 0x5a, 112);
+  char *large = static_cast<char *>(
+      MPAllocator::reallocate(block, 112, 4096));
+  for(unsigned i = 0; i < 112; i++)
+    EXPECT_EQ(large[i], 0x5a);
+  MPAllocator::deallocate(large, 4096);
+  mpfr::mpreal val(1.0, 4096);
+  val = mpfr::sqrt(val * 2);
+  val.set_prec(64);
+  EXPECT_EQ(val, mpfr::sqrt(mpfr::mpreal(2.0, 64)));
+}
+
+/* A thread's slabs are freed when it exits, unless one of
+ * their blocks is still allocated
+ */
+TEST(MPAllocator, freesSlabsAtThreadExit) {
+  const size_t slabs = MPAllocator::numSlabs();
+  void *kept = NULL;
+  std::thread([]() {
+    for(unsigned i = 0; i < 100; i++) {
+      void *block = MPAllocator::allocate(1000);
+      MPAllocator::deallocate(block, 1000);
+    }
+    mpfr::mpreal val(3.0, 4096);
+    val = mpfr::sqrt(val);
+  }).join();
+  EXPECT_EQ(MPAllocator::numSlabs(), slabs);
+  std::thread([&kept]() {
+    kept = MPAllocator::allocate(1000);
+    std::memset(kept, 0x5a, 1000);
+  }).join();
+  EXPECT_EQ(MPAllocator::numSlabs(), slabs + 1);
+  EXPECT_EQ(static_cast<char *>(kept)[999], 0x5a);
+  MPAllocator::deallocate(kept, 1000);
+}
+
+/* Products of doubles and their sums fit in 1024 bits,
+ * so FixedMP is exact where a double sum cancels
+ */
+TEST(FixedMP, exactDotProduct) {
+  const double v1[] = {1e30, 1.0, -1e30, 0.1};
+  const double v2[] = {1.0, 1.0, 1.0, 0.1};
+  FixedMP<1024> sum;
+  mpfr::mpreal exact(0.0, 1024);
+  for(unsigned i = 0; i < 4; i++) {
+    sum.addProduct(FixedMP<1024>(v1[i]),
+                   FixedMP<1024>(v2[i]));
+    exact += mpfr::mpreal(v1[i], 1024) * v2[i];
+  }
+  EXPECT_EQ(sum.toMPReal(), exact);
+  FixedMP<1024> copy(sum);
+  copy -= FixedMP<1024>(1.0);
+  const FixedMP<1024> last = FixedMP<1024>::fma(
+      FixedMP<1024>(v1[3]), FixedMP<1024>(v2[3]),
+      FixedMP<1024>());
+  EXPECT_EQ(copy.toMPReal(), last.toMPReal());
+  EXPECT_EQ(sum.toMPReal(), exact);
+  /* Long doubles keep the bits a double would round off */
+  constexpr const int digits =
+      std::numeric_limits<long double>::digits;
+  const long double extended =
+      1.0L + std::ldexp(1.0L, 1 - digits);
+  const mpfr::mpreal converted =
+      FixedMP<digits>(extended).toMPReal();
+  EXPECT_EQ(converted, mpfr::mpreal(extended, digits));
+  EXPECT_EQ(converted.toLDouble(), extended);
+}
+
+TEST(ExactPrecision, extremeProducts) {
+  const double large =
+      std::nextafter(std::ldexp(1.0, 21), 0.0);
+  const double tiny =
+      std::numeric_limits<double>::denorm_min();
+  const double v[] = {large, tiny, -large};
+  const mpfr_prec_t prec = NumericTester::exactPrecision(
+      NumericTester::ulpExponent<double>(
+          std::numeric_limits<double>::min_exponent),
+      21, 2, 3);
+  for(mpfr_prec_t p : {prec, prec / 2}) {
+    mpfr::mpreal sum(0.0, p);
+    mpfr_clear_inexflag();
+    for(double val : v) {
+      const mpfr::mpreal term(val);
+      mpfr_fma(sum.mpfr_ptr(), term.mpfr_srcptr(),
+               term.mpfr_srcptr(), sum.mpfr_srcptr(),
+               MPFR_RNDN);
+    }
+    EXPECT_EQ(mpfr_inexflag_p() == 0, p == prec);
+  }
+}
+
+TEST(ReferenceCache, reloadsExactly) {
+  const std::string fname =
+      testing::TempDir() + "reference_cache_test.cache";
+  std::remove(fname.c_str());
+  const mpfr_prec_t prec = 200;
+  const std::vector<uint64_t> config = {1, 2, 3};
+  std::vector<mpfr::mpreal> refs;
+  const double vals[] = {0.0, -0.0, 1.0,
+                        std::ldexp(-1.0, -1000)};
+  for(double val : vals)
+    refs.push_back(mpfr::mpreal(val, prec));
+  refs.push_back(mpfr::const_pi(prec));
+  {
+    ReferenceCache cache(fname, 42, config, prec);
+    EXPECT_EQ(cache.mappedSize(), 0);
+    for(unsigned i = 0; i < refs.size(); i++)
+      cache.store(i, refs[i]);
+    cache.save();
+  }
+  {
+    ReferenceCache cache(fname, 42, config, prec);
+    ASSERT_EQ(cache.mappedSize(), refs.size());
+    for(unsigned i = 0; i < refs.size(); i++) {
+      mpfr::mpreal loaded;
+      cache.load(i, loaded);
+      EXPECT_EQ(loaded.get_prec(), prec);
+      EXPECT_EQ(loaded, refs[i]);
+      EXPECT_EQ(mpfr_signbit(loaded.mpfr_srcptr()) != 0,
+                mpfr_signbit(refs[i].mpfr_srcptr()) != 0);
+    }
+  }
+  const std::vector<uint64_t> changed = {1, 2, 4};
+  ReferenceCache stale(fname, 42, changed, prec);
+  EXPECT_EQ(stale.mappedSize(), 0);
+  ReferenceCache reseeded(fname, 43, config, prec);
+  EXPECT_EQ(reseeded.mappedSize(), 0);
+  std::remove(fname.c_str());
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,93 @@
+
+#ifndef _WORKER_POOL_HPP_
+#define _WORKER_POOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A fixed set of threads which run tasks together.
+ * run calls task(t) for every t below size(), each on its
+ * own thread, and returns once they have all finished; the
+ * calling thread runs task(0).
+ * The threads are created with the pool and wait for the
+ * next task in between, so running a task costs a wake up
+ * rather than creating threads
+ */
+class WorkerPool {
+ public:
+  explicit WorkerPool(unsigned numThreads)
+      : numThreads(numThreads),
+        threads(),
+        lock(),
+        started(),
+        finished(),
+        task(NULL),
+        generation(0),
+        pending(0),
+        stopping(false) {
+    for(unsigned t = 1; t < numThreads; t++)
+      threads.emplace_back(&WorkerPool::work, this, t);
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+    }
+    started.notify_all();
+    for(auto &thread : threads) thread.join();
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  unsigned size() const { return numThreads; }
+
+  void run(const std::function<void(unsigned)> &job) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      task = &job;
+      generation++;
+      pending = numThreads - 1;
+    }
+    started.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this]() { return pending == 0; });
+  }
+
+ private:
+  void work(unsigned t) {
+    unsigned long seen = 0;
+    for(;;) {
+      const std::function<void(unsigned)> *job;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        started.wait(guard, [this, seen]() {
+          return stopping || generation != seen;
+        });
+        if(stopping) return;
+        seen = generation;
+        job = task;
+      }
+      (*job)(t);
+      std::lock_guard<std::mutex> guard(lock);
+      pending--;
+      if(pending == 0) finished.notify_one();
+    }
+  }
+
+  const unsigned numThreads;
+  std::vector<std::thread> threads;
+  std::mutex lock;
+  std::condition_variable started, finished;
+  const std::function<void(unsigned)> *task;
+  unsigned long generation;
+  unsigned pending;
+  bool stopping;
+};
+
+#endif